@@ -0,0 +1,454 @@
+// Замеры стоимости тика по частям: ns/op и выделения памяти на операцию.
+// Входные данные генерируются (см. Fixture.hpp), размер задаётся ключами.
+//
+//   make bench BENCH_ARGS="--cores=64 --disks=8 --interfaces=4"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "CpuCollector.hpp"
+#include "DiskCollector.hpp"
+#include "Fixture.hpp"
+#include "Logger.hpp"
+#include "MemInfo.hpp"
+#include "MemoryCollector.hpp"
+#include "NetCollector.hpp"
+#include "NetlinkLinkReader.hpp"
+#include "ProcReader.hpp"
+#include "ProcessCollector.hpp"
+#include "SnapshotFormatter.hpp"
+#include "StreamWriter.hpp"
+#include "ThreadPool.hpp"
+#include "TimeSeriesStore.hpp"
+
+namespace {
+std::atomic<std::uint64_t> g_allocations{0};
+
+void* countedAlloc(std::size_t size, std::size_t alignment) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) {
+        size = 1;
+    }
+    void* p = (alignment <= alignof(std::max_align_t))
+        ? std::malloc(size)
+        : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+}
+
+// Считаем каждое выделение во всём процессе, включая потоки пула и логгера
+void* operator new(std::size_t size) { return countedAlloc(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return countedAlloc(size, static_cast<std::size_t>(alignment));
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+struct BenchResult {
+    std::string name;
+    std::uint64_t iterations;
+    double ns_per_op;
+    double allocs_per_op;
+};
+
+// Величина, выведенная из замеров, а не время одной операции
+struct BenchNote {
+    std::string name;
+    double value;
+    std::string unit;
+};
+
+struct BenchOptions {
+    SyntheticFixtureSpec spec;
+    std::chrono::milliseconds min_time{200};
+    std::string output;
+    std::string filter;
+};
+
+// Не даём компилятору выбросить результат замеряемого кода
+volatile std::uint64_t g_sink = 0;
+
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchOptions& options) : options_(options) {}
+
+    // Гоняет f партиями удваивающегося размера, пока не наберётся min_time.
+    // Первый вызов — прогрев: буферы дорастают до рабочего размера.
+    template<class F>
+    void run(const std::string& name, F&& f) {
+        if (name.find(options_.filter) == std::string::npos) {
+            return;
+        }
+        f();
+        std::uint64_t iterations = 0;
+        std::uint64_t batch = 1;
+        std::uint64_t allocations = g_allocations.load(std::memory_order_relaxed);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::chrono::steady_clock::duration elapsed{};
+        while (true) {
+            for (std::uint64_t i = 0; i < batch; ++i) {
+                f();
+            }
+            iterations += batch;
+            elapsed = std::chrono::steady_clock::now() - start;
+            if (elapsed >= options_.min_time) {
+                break;
+            }
+            batch *= 2;
+        }
+        allocations = g_allocations.load(std::memory_order_relaxed) - allocations;
+
+        BenchResult result{name, iterations,
+                           std::chrono::duration<double, std::nano>(elapsed).count() / iterations,
+                           static_cast<double>(allocations) / iterations};
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-32s %12llu %14.1f ns/op %10.2f allocs/op\n", name.c_str(),
+                      static_cast<unsigned long long>(iterations), result.ns_per_op, result.allocs_per_op);
+        std::cout << line << std::flush;
+        results_.push_back(result);
+    }
+
+    void note(const std::string& name, double value, const std::string& unit) {
+        if (name.find(options_.filter) == std::string::npos) {
+            return;
+        }
+        char line[160];
+        std::snprintf(line, sizeof(line), "%-32s %27.2f %s\n", name.c_str(), value, unit.c_str());
+        std::cout << line << std::flush;
+        notes_.push_back(BenchNote{name, value, unit});
+    }
+
+    // ns/op последнего замера с этим именем или 0, если он отфильтрован
+    double nsPerOp(const std::string& name) const {
+        for (const BenchResult& r : results_) {
+            if (r.name == name) {
+                return r.ns_per_op;
+            }
+        }
+        return 0;
+    }
+
+    // JSON для сравнения прогонов между коммитами
+    void writeJson(const std::string& path) const {
+        std::FILE* file = std::fopen(path.c_str(), "w");
+        if (file == nullptr) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+        std::fprintf(file, "{\n  \"params\": {\"cores\": %zu, \"disks\": %zu, \"interfaces\": %zu, \"min_time_ms\": %lld},\n"
+                     "  \"results\": [\n", options_.spec.cpus, options_.spec.disks, options_.spec.interfaces,
+                     static_cast<long long>(options_.min_time.count()));
+        for (std::size_t i = 0; i < results_.size(); ++i) {
+            const BenchResult& r = results_[i];
+            std::fprintf(file, "    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.3f}%s\n",
+                         r.name.c_str(), static_cast<unsigned long long>(r.iterations), r.ns_per_op,
+                         r.allocs_per_op, (i + 1 < results_.size()) ? "," : "");
+        }
+        std::fprintf(file, "  ],\n  \"notes\": [\n");
+        for (std::size_t i = 0; i < notes_.size(); ++i) {
+            const BenchNote& n = notes_[i];
+            std::fprintf(file, "    {\"name\": \"%s\", \"value\": %.3f, \"unit\": \"%s\"}%s\n",
+                         n.name.c_str(), n.value, n.unit.c_str(), (i + 1 < notes_.size()) ? "," : "");
+        }
+        std::fprintf(file, "  ]\n}\n");
+        std::fclose(file);
+    }
+
+private:
+    const BenchOptions& options_;
+    std::vector<BenchResult> results_;
+    std::vector<BenchNote> notes_;
+};
+
+std::string readText(const std::string& path) {
+    ProcReader reader(path);
+    std::string_view text = reader.read();
+    return std::string(text);
+}
+
+bool matchOption(const std::string& arg, const std::string& prefix, std::string& value) {
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+void runBenchmarks(const BenchOptions& options, const std::string& dir) {
+    BenchRunner runner(options);
+    std::string root = dir + "/000001";
+    Logger null_logger("/dev/null", Logger::Level::ERROR);
+
+    CpuCollector cpu(true, root, null_logger);
+    std::string stat = readText(root + "/stat");
+    std::string_view cpu_line = std::string_view(stat).substr(0, stat.find('\n'));
+    CpuTimeArrays cpu_times;
+    cpu_times.reserve(1);
+    runner.run("cpu.parse_line", [&] {
+        cpu.parseCpuLine(cpu_line, cpu_times, 0);
+        g_sink = g_sink + cpu_times.state[CPU_USER][0];
+    });
+    runner.run("cpu.read_all_cores", [&] {
+        g_sink = g_sink + cpu.readCpuTimes(cpu_times, true);
+    });
+    runner.run("cpu.collect", [&] { cpu.collect(); });
+
+    std::string diskstats = readText(root + "/diskstats");
+    NameTable disk_names;
+    std::vector<DiskStats> disks;
+    runner.run("disk.read_diskstats", [&] {
+        readDiskStats(diskstats, disk_names, disks);
+        g_sink = g_sink + disks.size();
+    });
+
+    std::string netdev = readText(root + "/net/dev");
+    NameTable net_names;
+    std::vector<NetInterface> interfaces;
+    runner.run("net.read_netdev", [&] {
+        readNetDev(netdev, net_names, interfaces);
+        g_sink = g_sink + interfaces.size();
+    });
+
+    // Оба источника на интерфейсах этой машины: rtnetlink синтетику не читает
+    ProcReader live_netdev("/proc/net/dev");
+    NameTable live_names;
+    runner.run("net.live.proc_net_dev", [&] {
+        readNetDev(live_netdev.read(), live_names, interfaces);
+        g_sink = g_sink + interfaces.size();
+    });
+    try {
+        NetlinkLinkReader netlink;
+        runner.run("net.live.rtnetlink", [&] {
+            netlink.read(live_names, interfaces);
+            g_sink = g_sink + interfaces.size();
+        });
+    } catch (const std::exception& e) {
+        std::cout << "net.live.rtnetlink skipped: " << e.what() << "\n";
+    }
+
+    std::string meminfo = readText(root + "/meminfo");
+    MemInfo info;
+    runner.run("memory.parse_meminfo", [&] {
+        parseMemInfo(meminfo, info);
+        g_sink = g_sink + info.present;
+    });
+
+    MemoryCollector memory(root, null_logger);
+    runner.run("memory.collect", [&] { memory.collect(); });
+
+    // Процессы этой машины: синтетических /proc/[pid] нет
+    {
+        ProcessCollector processes("/proc", 10, ProcessSort::CPU, null_logger);
+        runner.run("process.live.collect", [&] { processes.collect(); });
+    }
+
+    {
+        Logger logger(dir + "/sync.log");
+        runner.run("logger.info.sync", [&] { logger.info("CPU: 12.5% | Memory: 42.0% | Disk: sda R 1.0 MiB/s"); });
+    }
+    {
+        Logger logger(dir + "/async.log", Logger::Level::INFO, Logger::AsyncOptions{});
+        runner.run("logger.info.async", [&] { logger.info("CPU: 12.5% | Memory: 42.0% | Disk: sda R 1.0 MiB/s"); });
+    }
+
+    {
+        ThreadPool pool(2);
+        runner.run("threadpool.enqueue_roundtrip", [&] {
+            g_sink = g_sink + pool.enqueue([] { return 1; }).get();
+        });
+    }
+
+    // Тик целиком, как в main: все коллекторы параллельно, затем текст кадра
+    std::vector<std::unique_ptr<IMetricCollector>> collectors;
+    collectors.push_back(std::make_unique<CpuCollector>(true, root, null_logger));
+    collectors.push_back(std::make_unique<MemoryCollector>(root, null_logger));
+    collectors.push_back(std::make_unique<DiskCollector>(root, "/sys", DeviceFilter(), null_logger));
+    collectors.push_back(std::make_unique<NetCollector>(root, NetBackend::PROC, DeviceFilter("", "lo"), null_logger));
+    std::vector<Task> tasks;
+    for (std::unique_ptr<IMetricCollector>& collector : collectors) {
+        IMetricCollector* c = collector.get();
+        tasks.emplace_back([c] { c->collect(); });
+    }
+    ThreadPool pool(collectors.size());
+    std::string frame;
+    runner.run("tick.end_to_end", [&] {
+        pool.submitAndWait(tasks.data(), tasks.size());
+        frame.clear();
+        for (std::unique_ptr<IMetricCollector>& collector : collectors) {
+            formatSnapshot(*collector->snapshot(), frame);
+            frame += '\n';
+        }
+        g_sink = g_sink + frame.size();
+    });
+    // Тот же тик, но вместо текста кадра — запись --output в /dev/null
+    int null_fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+    for (StreamFormat format : {StreamFormat::NDJSON, StreamFormat::CSV}) {
+        StreamWriter stream(null_fd, format);
+        runner.run(format == StreamFormat::NDJSON ? "tick.stream_ndjson" : "tick.stream_csv", [&] {
+            pool.submitAndWait(tasks.data(), tasks.size());
+            g_sink = g_sink + stream.write(collectors, std::chrono::steady_clock::now());
+        });
+    }
+    ::close(null_fd);
+
+    // История: тик каждые 100 мс по всем ядрам и интерфейсам. Загрузка ядра —
+    // доля из 10 тиков USER_HZ за 100 мс; трафик есть у каждого десятого
+    // интерфейса, ошибок почти нет. Бюджет — два блока на ряд, так что
+    // к концу замера в него входит и вытеснение старых блоков.
+    {
+        MetricSnapshot cpu_snapshot(MetricSource::CPU, {
+            MetricId::CPU_USAGE_PERCENT, MetricId::CPU_CORES, MetricId::CPU_USER_PERCENT,
+            MetricId::CPU_NICE_PERCENT, MetricId::CPU_SYSTEM_PERCENT, MetricId::CPU_IDLE_PERCENT,
+            MetricId::CPU_IOWAIT_PERCENT, MetricId::CPU_IRQ_PERCENT, MetricId::CPU_SOFTIRQ_PERCENT,
+            MetricId::CPU_STEAL_PERCENT, MetricId::CPU_GUEST_PERCENT});
+        MetricSnapshot net_snapshot(MetricSource::NET, {
+            MetricId::NET_RX_MIB_S, MetricId::NET_TX_MIB_S, MetricId::NET_RX_PACKETS_S, MetricId::NET_TX_PACKETS_S,
+            MetricId::NET_RX_ERRORS_S, MetricId::NET_TX_ERRORS_S, MetricId::NET_RX_DROPS_S, MetricId::NET_TX_DROPS_S,
+            MetricId::NET_RX_FIFO_S, MetricId::NET_TX_FIFO_S, MetricId::NET_RX_MULTICAST_S,
+            MetricId::NET_RX_PACKET_BYTES, MetricId::NET_TX_PACKET_BYTES});
+        std::vector<std::string> cpu_names;
+        for (std::size_t cpu = 0; cpu < options.spec.cpus; ++cpu) {
+            cpu_names.push_back("cpu" + std::to_string(cpu));
+        }
+        std::vector<std::string> net_names;
+        for (std::size_t i = 0; i < options.spec.interfaces; ++i) {
+            net_names.push_back("veth" + std::to_string(i));
+        }
+        std::uint64_t state = 88172645463325252ull;
+        auto random = [&state](std::uint64_t bound) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            return state % bound;
+        };
+        std::int64_t time_ms = 0;
+        auto tick = [&] {
+            time_ms += 100 + static_cast<std::int64_t>(random(3));
+            double seconds = (100 + random(2000) / 1000.0) / 1000.0;
+            cpu_snapshot.beginRows();
+            for (const std::string& name : cpu_names) {
+                double* m = cpu_snapshot.addRow(name);
+                double busy = static_cast<double>(random(11));
+                double system = static_cast<double>(random(static_cast<std::uint64_t>(busy) + 1));
+                m[0] = busy * 10;
+                m[1] = 1;
+                m[2] = (busy - system) * 10;
+                m[4] = system * 10;
+                m[5] = 100 - busy * 10;
+                m[3] = m[6] = m[7] = m[8] = m[9] = m[10] = 0;
+            }
+            cpu_snapshot.endRows(std::chrono::steady_clock::time_point(std::chrono::milliseconds(time_ms)));
+            net_snapshot.beginRows();
+            for (std::size_t i = 0; i < net_names.size(); ++i) {
+                double* m = net_snapshot.addRow(net_names[i]);
+                std::fill(m, m + net_snapshot.columns.size(), 0.0);
+                if (i % 10 == 0) {
+                    double rx_packets = static_cast<double>(random(5000));
+                    double tx_packets = static_cast<double>(random(5000));
+                    double rx_bytes = rx_packets * static_cast<double>(64 + random(1400));
+                    double tx_bytes = tx_packets * static_cast<double>(64 + random(1400));
+                    m[0] = rx_bytes / seconds / 1048576.0;
+                    m[1] = tx_bytes / seconds / 1048576.0;
+                    m[2] = rx_packets / seconds;
+                    m[3] = tx_packets / seconds;
+                    m[6] = (random(100) == 0) ? 1 / seconds : 0;
+                    m[11] = rx_packets > 0 ? rx_bytes / rx_packets : 0;
+                    m[12] = tx_packets > 0 ? tx_bytes / tx_packets : 0;
+                }
+            }
+            net_snapshot.endRows(std::chrono::steady_clock::time_point(std::chrono::milliseconds(time_ms)));
+        };
+        std::size_t series_count = cpu_snapshot.columns.size() * cpu_names.size() +
+                                   net_snapshot.columns.size() * net_names.size();
+        double samples_per_tick = static_cast<double>(series_count);
+        TimeSeriesStore history(2 * series_count * TimeSeriesStore::blockBytes());
+        // Снимок готовится вне замера: отдельно меряется только его генерация
+        runner.run("history.generate_tick", tick);
+        runner.run("history.append_tick", [&] {
+            tick();
+            history.append(0, cpu_snapshot);
+            history.append(1, net_snapshot);
+        });
+        double append_ns = runner.nsPerOp("history.append_tick") - runner.nsPerOp("history.generate_tick");
+        if (append_ns > 0 && history.samples() > 0) {
+            runner.note("history.append_per_sample", append_ns / samples_per_tick, "ns/sample");
+            runner.note("history.bytes_per_sample", static_cast<double>(history.bytesUsed()) / history.samples(),
+                        "bytes/sample");
+        }
+        std::uint32_t series = history.findSeries("net/veth0/net.rx_mib_s");
+        std::vector<SeriesSample> points;
+        runner.run("history.query_series", [&] {
+            points.clear();
+            history.query(series, INT64_MIN, INT64_MAX, points);
+            g_sink = g_sink + points.size();
+        });
+    }
+
+    if (!options.output.empty()) {
+        runner.writeJson(options.output);
+        std::cout << "Results written to " << options.output << "\n";
+    }
+}
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value;
+        if (matchOption(arg, "--cores=", value)) {
+            options.spec.cpus = std::stoul(value);
+        } else if (matchOption(arg, "--disks=", value)) {
+            options.spec.disks = std::stoul(value);
+        } else if (matchOption(arg, "--interfaces=", value)) {
+            options.spec.interfaces = std::stoul(value);
+        } else if (matchOption(arg, "--min-time=", value)) {
+            options.min_time = std::chrono::milliseconds(std::stoul(value));
+        } else if (matchOption(arg, "--output=", value)) {
+            options.output = value;
+        } else if (matchOption(arg, "--filter=", value)) {
+            options.filter = value;
+        } else {
+            std::cerr << "Usage: sysmon-bench [--cores=<n>] [--disks=<n>] [--interfaces=<n>]\n"
+                         "                    [--min-time=<ms>] [--filter=<substring>] [--output=<file.json>]\n";
+            return 1;
+        }
+    }
+
+    char dir_template[] = "/tmp/sysmon-bench-XXXXXX";
+    if (mkdtemp(dir_template) == nullptr) {
+        std::cerr << "Cannot create temporary directory\n";
+        return 1;
+    }
+    std::string dir = dir_template;
+    int status = 0;
+    try {
+        options.spec.frames = 2;
+        generateFixture(dir, options.spec);
+        std::cout << "cores=" << options.spec.cpus << " disks=" << options.spec.disks
+                  << " interfaces=" << options.spec.interfaces << "\n";
+        runBenchmarks(options, dir);
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << "\n";
+        status = 1;
+    }
+    std::filesystem::remove_all(dir);
+    return status;
+}
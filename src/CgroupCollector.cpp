@@ -0,0 +1,397 @@
+#include "CgroupCollector.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include "ProcReader.hpp"
+
+namespace {
+// Порядок столбцов снимка
+enum CgroupColumn { COL_CPU, COL_MEMORY, COL_ANON, COL_FILE, COL_READ_MIB_S, COL_WRITE_MIB_S };
+
+constexpr std::size_t kReadBufferSize = 16 * 1024;
+// Хватает на сотни событий; остальное дочитается в следующем read()
+constexpr std::size_t kEventBufferSize = 64 * 1024;
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+bool exists(const std::string& path) {
+    return ::access(path.c_str(), F_OK) == 0;
+}
+
+int openIn(int dir_fd, const char* name) {
+    return ::openat(dir_fd, name, O_RDONLY | O_CLOEXEC);
+}
+
+void closeFd(int& fd) {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+// Значение после "key=" в строке io.stat вида "8:0 rbytes=1 wbytes=2 ..."
+bool parseKeyValue(std::string_view token, std::string_view& key, std::uint64_t& value) {
+    std::size_t eq = token.find('=');
+    if (eq == std::string_view::npos) {
+        return false;
+    }
+    key = token.substr(0, eq);
+    std::string_view number = token.substr(eq + 1);
+    return parseUint(number, value);
+}
+}
+
+CgroupCollector::CgroupCollector(const std::string& cgroup_root, std::size_t max_depth, Logger& logger) :
+max_depth_(max_depth),
+buffer_(kReadBufferSize),
+events_(kEventBufferSize),
+snapshots_(MetricSnapshot(MetricSource::CGROUP, {
+    MetricId::CG_CPU_PERCENT, MetricId::CG_MEMORY_KB, MetricId::CG_ANON_KB,
+    MetricId::CG_FILE_KB, MetricId::CG_READ_MIB_S, MetricId::CG_WRITE_MIB_S})),
+logger_(logger) {
+    // Чистый v2 смонтирован в корень, гибридный — в <root>/unified
+    if (exists(cgroup_root + "/cgroup.controllers")) {
+        root_ = cgroup_root;
+    } else if (exists(cgroup_root + "/unified/cgroup.controllers")) {
+        root_ = cgroup_root + "/unified";
+    } else {
+        logger_.error("No cgroup v2 hierarchy under " + cgroup_root);
+        throw std::runtime_error("No cgroup v2 hierarchy under " + cgroup_root);
+    }
+
+    root_fd_ = ::open(root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (root_fd_ < 0) {
+        logger_.error("Cannot open " + root_);
+        throw std::runtime_error("Cannot open " + root_);
+    }
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        ::close(root_fd_);
+        logger_.error("Cannot create inotify instance");
+        throw std::runtime_error("Cannot create inotify instance");
+    }
+    root_watch_ = watch("");
+    addChildren("", root_fd_, 0);
+    logger_.info("CgroupCollector start. " + std::to_string(names_.size()) + " cgroups under " + root_);
+}
+
+CgroupCollector::~CgroupCollector() {
+    for (Group& group : groups_) {
+        closeGroup(group);
+    }
+    ::close(inotify_fd_);
+    ::close(root_fd_);
+}
+
+int CgroupCollector::watch(const std::string& path) {
+    std::string full = path.empty() ? root_ : root_ + "/" + path;
+    int wd = ::inotify_add_watch(inotify_fd_, full.c_str(), IN_CREATE | IN_DELETE | IN_ONLYDIR);
+    if (wd < 0 && errno != ENOENT && !watch_limit_logged_) {
+        // Обычно упёрлись в fs.inotify.max_user_watches: группы ниже не появятся
+        logger_.warning("Cannot watch " + full + ": " + std::strerror(errno));
+        watch_limit_logged_ = true;
+    }
+    return wd;
+}
+
+void CgroupCollector::addGroup(const std::string& path, std::size_t depth) {
+    std::uint32_t slot = names_.find(path);
+    if (slot != NameTable::kNoSlot && groups_[slot].live) {
+        return; // уже нашли обходом — событие пришло следом
+    }
+    int dir_fd = ::openat(root_fd_, path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd < 0) {
+        return; // удалена, пока до неё дошли
+    }
+    slot = names_.intern(path);
+    if (groups_.size() < names_.slotCount()) {
+        groups_.resize(names_.slotCount());
+    }
+    Group& group = groups_[slot];
+    group = Group{};
+    group.live = true;
+    group.depth = depth;
+    group.dir_fd = dir_fd;
+    group.cpu_fd = openIn(dir_fd, "cpu.stat");
+    group.memory_fd = openIn(dir_fd, "memory.current");
+    group.memory_stat_fd = openIn(dir_fd, "memory.stat");
+    group.io_fd = openIn(dir_fd, "io.stat");
+    order_dirty_ = true;
+
+    if (depth < max_depth_) {
+        // Сначала подписка, потом обход: так не теряются дети, созданные между ними
+        int wd = watch(path);
+        groups_[slot].watch = wd;
+        if (wd >= 0) {
+            watch_slots_[wd] = slot;
+        }
+        addChildren(path, dir_fd, depth);
+    }
+}
+
+void CgroupCollector::addChildren(const std::string& path, int dir_fd, std::size_t depth) {
+    int fd = ::dup(dir_fd);
+    if (fd < 0) {
+        return;
+    }
+    DIR* dir = ::fdopendir(fd);
+    if (dir == nullptr) {
+        ::close(fd);
+        return;
+    }
+    while (dirent* entry = ::readdir(dir)) {
+        if (entry->d_type != DT_DIR || std::strcmp(entry->d_name, ".") == 0 ||
+            std::strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+        addGroup(path.empty() ? std::string(entry->d_name) : path + "/" + entry->d_name, depth + 1);
+    }
+    ::closedir(dir);
+}
+
+void CgroupCollector::closeGroup(Group& group) {
+    closeFd(group.cpu_fd);
+    closeFd(group.memory_fd);
+    closeFd(group.memory_stat_fd);
+    closeFd(group.io_fd);
+    closeFd(group.dir_fd);
+    group.live = false;
+}
+
+void CgroupCollector::removeGroup(std::uint32_t slot) {
+    // Потомки удаляются раньше родителя, но события могли потеряться
+    std::string prefix = std::string(names_.name(slot)) + "/";
+    for (std::uint32_t other = 0; other < groups_.size(); ++other) {
+        if (other != slot && groups_[other].live &&
+            names_.name(other).compare(0, prefix.size(), prefix) == 0) {
+            removeGroup(other);
+        }
+    }
+    Group& group = groups_[slot];
+    if (group.watch >= 0) {
+        ::inotify_rm_watch(inotify_fd_, group.watch);
+        watch_slots_.erase(group.watch);
+    }
+    closeGroup(group);
+    names_.release(slot);
+    order_dirty_ = true;
+}
+
+void CgroupCollector::rescan() {
+    for (std::uint32_t slot = 0; slot < groups_.size(); ++slot) {
+        if (groups_[slot].live) {
+            removeGroup(slot);
+        }
+    }
+    addChildren("", root_fd_, 0);
+}
+
+void CgroupCollector::drainEvents() {
+    bool overflow = false;
+    while (true) {
+        ssize_t n = ::read(inotify_fd_, events_.data(), events_.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                break;
+            }
+            throw std::runtime_error("Cannot read inotify events");
+        }
+        for (ssize_t offset = 0; offset < n;) {
+            inotify_event event;
+            std::memcpy(&event, events_.data() + offset, sizeof(event));
+            const char* name = events_.data() + offset + sizeof(inotify_event);
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event.len);
+
+            if (event.mask & IN_Q_OVERFLOW) {
+                overflow = true;
+                continue;
+            }
+            std::string parent;
+            std::size_t depth = 0;
+            if (event.wd != root_watch_) {
+                std::unordered_map<int, std::uint32_t>::const_iterator it = watch_slots_.find(event.wd);
+                if (it == watch_slots_.end()) {
+                    continue; // подписка уже снята вместе с группой
+                }
+                if (event.mask & IN_IGNORED) {
+                    // Каталог исчез, а IN_DELETE от родителя мы не видели
+                    groups_[it->second].watch = -1;
+                    watch_slots_.erase(it);
+                    continue;
+                }
+                parent = std::string(names_.name(it->second)) + "/";
+                depth = groups_[it->second].depth;
+            }
+            if (!(event.mask & IN_ISDIR) || event.len == 0) {
+                continue;
+            }
+            std::string path = parent + name;
+            if (event.mask & IN_CREATE) {
+                addGroup(path, depth + 1);
+            } else if (event.mask & IN_DELETE) {
+                std::uint32_t slot = names_.find(path);
+                if (slot != NameTable::kNoSlot && groups_[slot].live) {
+                    removeGroup(slot);
+                }
+            }
+        }
+    }
+    if (overflow) {
+        logger_.warning("inotify queue overflow, rescanning " + root_);
+        rescan();
+    }
+}
+
+long CgroupCollector::readAt(int fd) {
+    if (fd < 0) {
+        return -1;
+    }
+    while (true) {
+        ssize_t n = ::pread(fd, buffer_.data(), buffer_.size(), 0);
+        if (n < static_cast<ssize_t>(buffer_.size())) {
+            return n;
+        }
+        buffer_.resize(buffer_.size() * 2);
+    }
+}
+
+void CgroupCollector::collect() {
+    try {
+        drainEvents();
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double interval_sec = std::chrono::duration<double>(now - prev_time_).count();
+
+        if (order_dirty_) {
+            order_.clear();
+            for (std::uint32_t slot = 0; slot < groups_.size(); ++slot) {
+                if (groups_[slot].live) {
+                    order_.push_back(slot);
+                }
+            }
+            std::sort(order_.begin(), order_.end(), [this](std::uint32_t a, std::uint32_t b) {
+                return names_.name(a) < names_.name(b);
+            });
+            order_dirty_ = false;
+        }
+
+        bool publish = !first_run_;
+        MetricSnapshot* snapshot = nullptr;
+        if (publish) {
+            snapshot = &snapshots_.beginWrite();
+            snapshot->beginRows();
+        }
+        for (std::uint32_t slot : order_) {
+            Group& group = groups_[slot];
+            long n = readAt(group.cpu_fd);
+            if (n <= 0) {
+                // Группа удалена, а событие ещё не прочитано
+                group.has_prev = false;
+                continue;
+            }
+            std::uint64_t usage_usec = 0;
+            std::string_view text(buffer_.data(), static_cast<std::size_t>(n));
+            std::string_view line;
+            while (nextLine(text, line)) {
+                if (nextToken(line) == "usage_usec") {
+                    parseUint(line, usage_usec);
+                    break;
+                }
+            }
+
+            double memory_kb = kNaN;
+            n = readAt(group.memory_fd);
+            if (n > 0) {
+                std::string_view value(buffer_.data(), static_cast<std::size_t>(n));
+                std::uint64_t bytes = 0;
+                if (parseUint(value, bytes)) {
+                    memory_kb = bytes / 1024.0;
+                }
+            }
+
+            double anon_kb = kNaN;
+            double file_kb = kNaN;
+            n = readAt(group.memory_stat_fd);
+            if (n > 0) {
+                text = std::string_view(buffer_.data(), static_cast<std::size_t>(n));
+                while (nextLine(text, line)) {
+                    std::string_view key = nextToken(line);
+                    std::uint64_t bytes = 0;
+                    if (key == "anon" && parseUint(line, bytes)) {
+                        anon_kb = bytes / 1024.0;
+                    } else if (key == "file" && parseUint(line, bytes)) {
+                        file_kb = bytes / 1024.0;
+                    }
+                }
+            }
+
+            // io.stat — строка на устройство; суммируем по всем
+            bool has_io = false;
+            std::uint64_t read_bytes = 0;
+            std::uint64_t write_bytes = 0;
+            n = readAt(group.io_fd);
+            if (n >= 0) {
+                has_io = true;
+                text = std::string_view(buffer_.data(), static_cast<std::size_t>(n));
+                while (nextLine(text, line)) {
+                    nextToken(line); // major:minor
+                    for (std::string_view token = nextToken(line); !token.empty(); token = nextToken(line)) {
+                        std::string_view key;
+                        std::uint64_t value = 0;
+                        if (!parseKeyValue(token, key, value)) {
+                            continue;
+                        }
+                        if (key == "rbytes") {
+                            read_bytes += value;
+                        } else if (key == "wbytes") {
+                            write_bytes += value;
+                        }
+                    }
+                }
+            }
+
+            if (publish && group.has_prev && interval_sec > 0) {
+                double* row = snapshot->addRow(names_.name(slot));
+                std::uint64_t usage_diff = (usage_usec > group.usage_usec) ? usage_usec - group.usage_usec : 0;
+                // Как в top: 100% — одно ядро
+                row[COL_CPU] = usage_diff / 1e6 / interval_sec * 100.0;
+                row[COL_MEMORY] = memory_kb;
+                row[COL_ANON] = anon_kb;
+                row[COL_FILE] = file_kb;
+                if (has_io) {
+                    std::uint64_t read_diff = (read_bytes > group.read_bytes) ? read_bytes - group.read_bytes : 0;
+                    std::uint64_t write_diff = (write_bytes > group.write_bytes) ? write_bytes - group.write_bytes : 0;
+                    row[COL_READ_MIB_S] = read_diff / (1024.0 * 1024.0) / interval_sec;
+                    row[COL_WRITE_MIB_S] = write_diff / (1024.0 * 1024.0) / interval_sec;
+                } else {
+                    row[COL_READ_MIB_S] = kNaN;
+                    row[COL_WRITE_MIB_S] = kNaN;
+                }
+            }
+            group.usage_usec = usage_usec;
+            group.read_bytes = read_bytes;
+            group.write_bytes = write_bytes;
+            group.has_prev = true;
+        }
+        if (publish) {
+            snapshot->endRows(now);
+            snapshots_.publish();
+        }
+        prev_time_ = now;
+        first_run_ = false;
+    } catch (const std::exception& e) {
+        logger_.error(e.what());
+        MetricSnapshot& snapshot = snapshots_.beginWrite();
+        snapshot.beginRows();
+        snapshot.endRows(std::chrono::steady_clock::now());
+        snapshots_.publish();
+    }
+}
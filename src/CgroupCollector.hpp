@@ -0,0 +1,84 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "Logger.hpp"
+#include "NameTable.hpp"
+#include "IMetricCollector.hpp"
+
+// Контейнеры и службы по cgroup v2: CPU%, память и скорость IO каждой
+// группы из cpu.stat, memory.current, memory.stat и io.stat.
+//
+// Дерево обходится один раз при запуске. Дальше появление и удаление групп
+// приходят через inotify (IN_CREATE/IN_DELETE на каталогах), так что тик
+// не перечитывает каталоги, а только pread() уже открытых файлов групп.
+// Группы глубже max_depth не отслеживаются. При гибридной раскладке
+// (v1 + v2 в <root>/unified) берётся unified; файлов контроллеров,
+// привязанных к v1, там нет — такие столбцы остаются NaN.
+class CgroupCollector : public IMetricCollector {
+public:
+    CgroupCollector(const std::string& cgroup_root, std::size_t max_depth, Logger& logger);
+    ~CgroupCollector() override;
+
+    CgroupCollector(const CgroupCollector&) = delete;
+    CgroupCollector& operator=(const CgroupCollector&) = delete;
+
+    void collect() override;
+    SnapshotGuard snapshot() const override { return snapshots_.read(); }
+
+    const std::string& root() const { return root_; }
+    std::size_t groupCount() const { return names_.size(); }
+
+private:
+    struct Group {
+        bool live = false;
+        bool has_prev = false;
+        std::size_t depth = 0;
+        int dir_fd = -1;
+        int watch = -1;
+        int cpu_fd = -1;            // cpu.stat
+        int memory_fd = -1;         // memory.current
+        int memory_stat_fd = -1;    // memory.stat
+        int io_fd = -1;             // io.stat
+        std::uint64_t usage_usec = 0;
+        std::uint64_t read_bytes = 0;
+        std::uint64_t write_bytes = 0;
+    };
+
+    // Добавляет группу и (в пределах глубины) всех её потомков
+    void addGroup(const std::string& path, std::size_t depth);
+    void addChildren(const std::string& path, int dir_fd, std::size_t depth);
+    // Удаляет группу и всех её потомков
+    void removeGroup(std::uint32_t slot);
+    void closeGroup(Group& group);
+    int watch(const std::string& path);
+    void rescan();
+    void drainEvents();
+    // Длина прочитанного или -1
+    long readAt(int fd);
+
+    std::string root_;
+    std::size_t max_depth_;
+    int root_fd_ = -1;
+    int inotify_fd_ = -1;
+    int root_watch_ = -1;
+    bool watch_limit_logged_ = false;
+
+    NameTable names_;                                       // путь от корня -> слот
+    std::vector<Group> groups_;                             // по номеру слота
+    std::unordered_map<int, std::uint32_t> watch_slots_;    // inotify wd -> слот
+    std::vector<std::uint32_t> order_;                      // живые слоты по пути
+    bool order_dirty_ = true;
+
+    std::vector<char> buffer_;
+    std::vector<char> events_;
+    bool first_run_ = true;
+    std::chrono::steady_clock::time_point prev_time_;
+
+    SnapshotBuffer<MetricSnapshot> snapshots_;
+    Logger& logger_;
+};
@@ -0,0 +1,95 @@
+#include "CollectorScheduler.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+CollectorScheduler::CollectorScheduler(Clock::time_point start) :
+start_(start) {
+}
+
+std::size_t CollectorScheduler::add(IMetricCollector& collector, std::chrono::nanoseconds period) {
+    if (period.count() <= 0) {
+        throw std::invalid_argument("Collector period must be > 0");
+    }
+    std::size_t index = entries_.size();
+    entries_.push_back(Entry{&collector, period, period, start_});
+    heap_.push_back(index);
+    std::push_heap(heap_.begin(), heap_.end(),
+                   [this](std::size_t a, std::size_t b) { return later(a, b); });
+    return index;
+}
+
+void CollectorScheduler::boost(std::size_t index, std::chrono::nanoseconds period, Clock::time_point until) {
+    Entry& entry = entries_.at(index);
+    if (period.count() <= 0 || period >= entry.period) {
+        return;
+    }
+    entry.boost_period = period;
+    entry.boost_until = std::max(entry.boost_until, until);
+    Clock::time_point soonest = Clock::now() + period;
+    if (entry.deadline > soonest) {
+        entry.deadline = soonest;
+        std::make_heap(heap_.begin(), heap_.end(),
+                       [this](std::size_t a, std::size_t b) { return later(a, b); });
+    }
+}
+
+void CollectorScheduler::reportChange(std::size_t index, bool changed) {
+    Entry& entry = entries_.at(index);
+    if (max_period_.count() <= 0) {
+        return;
+    }
+    if (!changed) {
+        entry.current = std::min(entry.current * 2, std::max(max_period_, entry.period));
+        return;
+    }
+    if (entry.current == entry.period) {
+        return;
+    }
+    // Следующий сбор — не позже чем через обычный период от предыдущего
+    Clock::time_point soonest = entry.deadline - entry.current + entry.period;
+    entry.current = entry.period;
+    if (entry.deadline > soonest) {
+        entry.deadline = soonest;
+        std::make_heap(heap_.begin(), heap_.end(),
+                       [this](std::size_t a, std::size_t b) { return later(a, b); });
+    }
+}
+
+std::uint64_t CollectorScheduler::waitDue(std::vector<std::size_t>& due) {
+    due.clear();
+    if (heap_.empty()) {
+        return 0;
+    }
+    auto cmp = [this](std::size_t a, std::size_t b) { return later(a, b); };
+
+    if (!timer_.waitUntil(entries_[heap_.front()].deadline)) {
+        return 0;
+    }
+    Clock::time_point now = Clock::now();
+
+    std::uint64_t missed = 0;
+    while (!heap_.empty() && entries_[heap_.front()].deadline <= now) {
+        std::pop_heap(heap_.begin(), heap_.end(), cmp);
+        std::size_t index = heap_.back();
+        Entry& entry = entries_[index];
+        due.push_back(index);
+
+        // Следующий дедлайн считается от предыдущего, а не от now.
+        // Если опоздали больше чем на период — пропущенные тики не догоняем.
+        std::chrono::nanoseconds period = entry.current;
+        if (entry.deadline < entry.boost_until) {
+            period = entry.boost_period;
+        } else {
+            skipped_.fetch_add(static_cast<std::uint64_t>(entry.current / entry.period) - 1, std::memory_order_relaxed);
+        }
+        entry.deadline += period;
+        if (entry.deadline <= now) {
+            std::uint64_t behind = static_cast<std::uint64_t>((now - entry.deadline) / period) + 1;
+            entry.deadline += period * behind;
+            missed += behind;
+        }
+        std::push_heap(heap_.begin(), heap_.end(), cmp);
+    }
+    missed_ticks_.fetch_add(missed, std::memory_order_relaxed);
+    return missed;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "IMetricCollector.hpp"
+#include "TickTimer.hpp"
+
+// Планировщик коллекторов с собственным периодом у каждого.
+// Дедлайны лежат в min-куче; waitDue() спит до ближайшего из них
+// и отдаёт только те коллекторы, чья очередь подошла.
+class CollectorScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit CollectorScheduler(Clock::time_point start = Clock::now());
+
+    // Возвращает индекс коллектора в планировщике.
+    std::size_t add(IMetricCollector& collector, std::chrono::nanoseconds period);
+
+    // Ждёт ближайший дедлайн и заполняет due индексами готовых коллекторов.
+    // Возвращает число дедлайнов, пропущенных ими с прошлого раза.
+    // Если ожидание прервал сигнал или wake(), due остаётся пустым.
+    std::uint64_t waitDue(std::vector<std::size_t>& due);
+
+    // Будит waitDue() из любого потока, например когда коллектор закончил сбор
+    void wake() { timer_.wake(); }
+    // Учесть дедлайн, который не стали обслуживать (коллектор ещё занят)
+    void markMissed() { missed_ticks_.fetch_add(1, std::memory_order_relaxed); }
+
+    // До момента until опрашивать коллектор с периодом period (если он
+    // короче обычного); повторный вызов продлевает ускорение. Ближайший
+    // дедлайн подтягивается, чтобы первый быстрый сбор был сразу.
+    void boost(std::size_t index, std::chrono::nanoseconds period, Clock::time_point until);
+
+    // Адаптивный режим: пока коллектор сообщает, что значения стабильны,
+    // его период удваивается до max_period; изменение возвращает обычный
+    // период и подтягивает дедлайн. 0 — режим выключен.
+    void setAdaptive(std::chrono::nanoseconds max_period) { max_period_ = max_period; }
+    void reportChange(std::size_t index, bool changed);
+
+    IMetricCollector& collector(std::size_t index) { return *entries_[index].collector; }
+    std::size_t size() const { return entries_.size(); }
+    // Счётчики можно читать из любого потока (их показывает SelfCollector)
+    std::uint64_t missedTicks() const { return missed_ticks_.load(std::memory_order_relaxed); }
+    // Сколько сборов с обычным периодом не понадобилось благодаря адаптивному режиму
+    std::uint64_t skippedCollections() const { return skipped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        IMetricCollector* collector;
+        std::chrono::nanoseconds period;
+        std::chrono::nanoseconds current;   // период с учётом адаптивного режима
+        Clock::time_point deadline;
+        std::chrono::nanoseconds boost_period{0};
+        Clock::time_point boost_until{};
+    };
+
+    bool later(std::size_t a, std::size_t b) const {
+        return entries_[a].deadline > entries_[b].deadline;
+    }
+
+    Clock::time_point start_;
+    std::vector<Entry> entries_;
+    std::vector<std::size_t> heap_;
+    TickTimer timer_;
+    std::atomic<std::uint64_t> missed_ticks_{0};
+    std::chrono::nanoseconds max_period_{0};
+    std::atomic<std::uint64_t> skipped_{0};
+};
@@ -1,185 +1,301 @@
 #include "CpuCollector.hpp"
-#include <iomanip>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
 #include <unistd.h>
 
-CpuCollector::CpuCollector(bool collect_per_core, Logger& logger) : 
-collect_per_core_(collect_per_core), 
+namespace {
+// Порядок столбцов снимка
+enum CpuColumn { COL_USAGE, COL_CORES, COL_USER, COL_NICE, COL_SYSTEM, COL_IDLE,
+                 COL_IOWAIT, COL_IRQ, COL_SOFTIRQ, COL_STEAL, COL_GUEST, COL_COUNT };
+
+// Больше ядер ядро Linux не поддерживает; защищает от мусорного номера в файле
+constexpr std::uint64_t kMaxCores = 1 << 16;
+
+// Векторные типы GCC: kCpuLanes строк за операцию. 16 байт есть в базовом
+// x86-64 (SSE2); с 32 байтами без -mavx сравнения разворачиваются в скаляры.
+typedef std::uint64_t TickLanes __attribute__((vector_size(kCpuLanes * sizeof(std::uint64_t))));
+typedef double PercentLanes __attribute__((vector_size(kCpuLanes * sizeof(double))));
+
+// Тики в double без поэлементного cvtsi2sd: число меньше 2^52 вписывается
+// в мантиссу 2^52, после чего 2^52 вычитается. Счётчики /proc/stat до 2^52
+// не дорастают.
+constexpr double kTwoPow52 = 4503599627370496.0;
+constexpr std::uint64_t kTwoPow52Bits = 0x4330000000000000ull;
+
+void loadTicks(const std::uint64_t* src, PercentLanes& out) {
+    TickLanes ticks;
+    std::memcpy(&ticks, src, sizeof(ticks));
+    ticks |= kTwoPow52Bits;
+    std::memcpy(&out, &ticks, sizeof(out));
+    out -= kTwoPow52;
+}
+
+void storeLanes(const PercentLanes& value, double* dst) {
+    std::memcpy(dst, &value, sizeof(value));
+}
+}
+
+void CpuTimeArrays::reserve(std::size_t count) {
+    if (count <= capacity()) {
+        return;
+    }
+    std::size_t padded = (count + kCpuLanes - 1) / kCpuLanes * kCpuLanes;
+    for (std::vector<std::uint64_t>& column : state) {
+        column.resize(padded, 0);
+    }
+    present.resize(padded, 0);
+}
+
+CpuCollector::CpuCollector(bool collect_per_core, const std::string& proc_root, Logger& logger) :
+collect_per_core_(collect_per_core),
+stat_reader_(proc_root + "/stat"),
+percents_(COL_COUNT),
 count_cores_(sysconf(_SC_NPROCESSORS_ONLN)),
+snapshots_(MetricSnapshot(MetricSource::CPU, {
+    MetricId::CPU_USAGE_PERCENT, MetricId::CPU_CORES, MetricId::CPU_USER_PERCENT,
+    MetricId::CPU_NICE_PERCENT, MetricId::CPU_SYSTEM_PERCENT, MetricId::CPU_IDLE_PERCENT,
+    MetricId::CPU_IOWAIT_PERCENT, MetricId::CPU_IRQ_PERCENT, MetricId::CPU_SOFTIRQ_PERCENT,
+    MetricId::CPU_STEAL_PERCENT, MetricId::CPU_GUEST_PERCENT})),
 logger_(logger) {
     logger_.info(
-        "CpuCollector start. Per core statistics is " + 
+        "CpuCollector start. Per core statistics is " +
         std::string((collect_per_core_) ? "enable.":"disable."));
-    if(collect_per_core_ == true) {
-        prev_cores_.reserve(count_cores_);
-        core_usage_percents_.reserve(count_cores_);
+    std::size_t rows = collect_per_core_ ? count_cores_ + 1 : 1;
+    current_.reserve(rows);
+    previous_.reserve(rows);
+    for (std::size_t column = 0; column < COL_COUNT; ++column) {
+        if (column != COL_CORES) {
+            percents_[column].resize(current_.capacity());
+        }
+    }
+    ticks_.resize(current_.capacity());
+}
+
+void CpuCollector::enableRollups(const std::string& sys_root, unsigned kinds) {
+    rollups_ = kinds;
+    if (rollups_ != 0) {
+        topology_ = std::make_unique<CpuTopology>(sys_root);
     }
 }
 
-CpuTimes CpuCollector::parseCpuLine(const std::string& line) {
-    std::istringstream iss(line);
-    std::string token;
-    iss >> token; 
+void CpuCollector::parseCpuLine(std::string_view line, CpuTimeArrays& times, std::size_t row) {
+    nextToken(line); // метка "cpu" / "cpuN"
 
-    std::vector<std::uint64_t> values;
-    while (iss >> token) {
-        std::size_t pos;
-        std::uint64_t val = std::stoull(token, &pos);
-        if (pos != token.size()) {
+    // Сначала в локальный массив: запись прямо в столбцы мешает компилятору
+    // держать line в регистрах (size_t и uint64_t могут совпадать по адресу)
+    std::uint64_t values[CPU_STATES];
+    for (std::uint64_t& value : values) {
+        if (!parseUint(line, value)) {
+            skipSpaces(line);
+            if (line.empty()) {
+                logger_.error("Not enough fields in CPU line");
+                throw std::runtime_error("Not enough fields in CPU line");
+            }
             logger_.error("Invalid number in CPU line");
             throw std::runtime_error("Invalid number in CPU line");
         }
-        values.push_back(val);
     }
-
-    if (values.size() < 10) {
-        logger_.error("Not enough fields in CPU line");
-        throw std::runtime_error("Not enough fields in CPU line");
+    for (std::size_t s = 0; s < CPU_STATES; ++s) {
+        times.state[s][row] = values[s];
     }
-
-    return CpuTimes{values[0], values[1], values[2], values[3],
-                    values[4], values[5], values[6], values[7],
-                    values[8], values[9]};
+    times.present[row] = 1;
+    times.rows = std::max(times.rows, row + 1);
 }
 
-CpuStats CpuCollector::readAllCpuCores() {
-    std::ifstream file("/proc/stat");
-    if (!file.is_open()) {
-        logger_.error("Cannot open /proc/stat");
-        throw std::runtime_error("Cannot open /proc/stat");
-    }
+std::size_t CpuCollector::readCpuTimes(CpuTimeArrays& times, bool per_core) {
+    std::string_view text = stat_reader_.read();
 
-    CpuStats stats;
-    std::string line;
-    while (std::getline(file, line)) {
+    std::fill(times.present.begin(), times.present.end(), 0);
+    times.rows = 0;
+    times.reserve(1);
+    bool has_total = false;
+    std::size_t cores = 0;
+    std::string_view line;
+    while (nextLine(text, line)) {
         if (line.substr(0, 4) == "cpu ") {
             // Общая статистика
-            stats.total = parseCpuLine(line);
-            stats.has_total = true;
+            parseCpuLine(line, times, 0);
+            has_total = true;
         } else if ( line.size() >= 4 && line.substr(0,3) == "cpu" &&
         std::isdigit(static_cast<unsigned char>(line[3]))) {
-            // По ядрам
-            stats.per_core.push_back(parseCpuLine(line));
+            // По ядрам; без per_core строку достаточно посчитать
+            ++cores;
+            if (per_core) {
+                std::string_view label = line.substr(3);
+                std::string_view number = nextToken(label);
+                std::uint64_t core = 0;
+                if (!parseUint(number, core) || core >= kMaxCores) {
+                    logger_.error("Invalid CPU number in /proc/stat");
+                    throw std::runtime_error("Invalid CPU number in /proc/stat");
+                }
+                times.reserve(core + 2);
+                parseCpuLine(line, times, core + 1);
+            }
+        } else if (has_total) {
+            // Строки cpuN идут подряд сразу после общей — дальше читать незачем
+            break;
         }
     }
-    if (!stats.has_total) {
+    if (!has_total) {
         logger_.error("Missing total CPU line in /proc/stat");
         throw std::runtime_error("Missing total CPU line in /proc/stat");
     }
-
-    return stats;
+    return cores;
 }
 
 void CpuCollector::collect() {
     try {
-        CpuStats current = readAllCpuCores();
-        if (first_run_ == true) {
-            prev_total_ = current.total;
-            if (collect_per_core_ == true) {
-                prev_cores_ = std::move(current.per_core);
-                core_usage_percents_.assign(prev_cores_.size(), 0.0);
+        std::size_t cores = readCpuTimes(current_, collect_per_core_ || rollups_ != 0);
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        // Появились новые ядра — оба буфера и результат растут вместе
+        std::size_t capacity = std::max(current_.capacity(), previous_.capacity());
+        current_.reserve(capacity);
+        previous_.reserve(capacity);
+        for (std::size_t column = 0; column < COL_COUNT; ++column) {
+            if (column != COL_CORES) {
+                percents_[column].resize(capacity);
+            }
+        }
+        ticks_.resize(capacity);
+        while (row_names_.size() < capacity) {
+            row_names_.push_back(row_names_.empty() ? "total" : "cpu" + std::to_string(row_names_.size() - 1));
+        }
+        if (topology_ && current_.present != topology_cpus_) {
+            // Набор CPU изменился (или это первый тик) — перечитываем sysfs
+            std::vector<std::size_t> cpus;
+            for (std::size_t i = 1; i < current_.rows; ++i) {
+                if (current_.present[i]) {
+                    cpus.push_back(i - 1);
+                }
             }
+            topology_->reload(cpus);
+            topology_cpus_ = current_.present;
+            logger_.info("CPU topology loaded: " + std::to_string(cpus.size()) + " CPUs, " +
+                         std::to_string(topology_->groups(GROUP_CORE)) + " cores, " +
+                         std::to_string(topology_->groups(GROUP_SOCKET)) + " sockets, " +
+                         std::to_string(topology_->groups(GROUP_NODE)) + " NUMA nodes");
+        }
+        if (first_run_ == true) {
+            std::swap(current_, previous_);
             first_run_ = false;
-            cpu_usage_percent_ = 0.0;
             return;
         }
 
-        cpu_usage_percent_ = calculateCpuUsage(current.total, prev_total_);
-        prev_total_ = current.total;
+        computePercents(current_.rows);
 
-        if (collect_per_core_ && !current.per_core.empty()) {
-            core_usage_percents_ = calculatePerCoreUsage(current.per_core, prev_cores_);
-            prev_cores_ = std::move(current.per_core);
+        MetricSnapshot& snapshot = snapshots_.beginWrite();
+        snapshot.beginRows();
+        // Сначала общая строка, за ней сводки по группам, потом ядра
+        std::size_t rows = collect_per_core_ ? current_.rows : 1;
+        for (std::size_t i = 0; i < rows; ++i) {
+            // Ядро, которого не было в прошлом чтении (только что включили),
+            // ещё не имеет интервала: его доли посчитаны от нулей
+            if (!current_.present[i] || !previous_.present[i]) {
+                continue;
+            }
+            double* row = snapshot.addRow(row_names_[i]);
+            // Ядра считаем по /proc/stat: с --proc-root он может быть не с этой машины
+            row[COL_CORES] = (i > 0) ? 1 : (cores == 0) ? count_cores_ : cores;
+            for (std::size_t column = 0; column < COL_COUNT; ++column) {
+                if (column != COL_CORES) {
+                    row[column] = percents_[column][i];
+                }
+            }
+            if (i == 0 && topology_) {
+                addRollups(snapshot);
+            }
         }
+        snapshot.endRows(now);
+        snapshots_.publish();
+        std::swap(current_, previous_);
     } catch (const std::exception& e) {
         logger_.error(std::string(e.what()));
-        std::cout << "Error:" << std::string(e.what());
     }
 }
 
-double CpuCollector::calculateCpuUsage(const CpuTimes& current, const CpuTimes& previous) {
-    auto active = [](const CpuTimes& t) {
-        return t.user + t.nice + t.system + t.irq + t.softirq + t.steal;
-    };
-    auto idle = [](const CpuTimes& t) {
-        return t.idle + t.iowait;
-    };
-
-    std::uint64_t active_curr = active(current);
-    std::uint64_t idle_curr = idle(current);
-    std::uint64_t total_curr = active_curr + idle_curr;
-
-    std::uint64_t active_prev = active(previous);
-    std::uint64_t idle_prev = idle(previous);
-    std::uint64_t total_prev = active_prev + idle_prev;
-
-    std::uint64_t active_diff = (active_curr > active_prev) ? (active_curr - active_prev) : 0;
-    std::uint64_t total_diff = (total_curr > total_prev) ? (total_curr - total_prev) : 0;
-    
-    if (total_diff == 0) return 0.0;
-    return (static_cast<double>(active_diff) / total_diff) * 100.0;
-}
-
-std::vector<double> CpuCollector::calculatePerCoreUsage(
-    const std::vector<CpuTimes>& current_cores,
-    const std::vector<CpuTimes>& previous_cores)
-{
-    auto active = [](const CpuTimes& t) {
-        return t.user + t.nice + t.system + t.irq + t.softirq + t.steal;
-    };
-    auto idle = [](const CpuTimes& t) {
-        return t.idle + t.iowait;
-    };
-
-    std::vector<double> usages;
-    usages.reserve(current_cores.size());
-
-    for (size_t i = 0; i < current_cores.size(); ++i) {
-        const CpuTimes& curr = current_cores[i];
-        const CpuTimes& prev = (i < previous_cores.size()) ? previous_cores[i] : curr;
-
-        uint64_t active_curr = active(curr);
-        uint64_t idle_curr = idle(curr);
-        uint64_t total_curr = active_curr + idle_curr;
-
-        uint64_t active_prev = active(prev);
-        uint64_t idle_prev = idle(prev);
-        uint64_t total_prev = active_prev + idle_prev;
-
-        uint64_t active_diff = (active_curr > active_prev) ? (active_curr - active_prev) : 0;
-        uint64_t total_diff = (total_curr > total_prev) ? (total_curr - total_prev) : 0;
-
-        double usage = (total_diff > 0) ? (static_cast<double>(active_diff) / total_diff) * 100.0 : 0.0;
-        usages.push_back(usage);
-    }
-
-    return usages;
-}
+void CpuCollector::computePercents(std::size_t rows) {
+    const PercentLanes zero = {};
+    const PercentLanes one = zero + 1.0;
 
-std::string CpuCollector::getFormattedData() {
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(1);
+    // Проход по kCpuLanes строкам сразу; массивы дополнены нулями до кратной длины
+    for (std::size_t i = 0; i < rows; i += kCpuLanes) {
+        PercentLanes delta[CPU_STATES];
+        for (std::size_t s = 0; s < CPU_STATES; ++s) {
+            PercentLanes now;
+            PercentLanes before;
+            loadTicks(&current_.state[s][i], now);
+            loadTicks(&previous_.state[s][i], before);
+            // Счётчик мог уйти назад (ядро выключали) — тогда тиков не было
+            PercentLanes diff = now - before;
+            delta[s] = (diff > zero) ? diff : zero;
+        }
+        // user и nice уже включают guest и guest_nice: вычитаем, чтобы доли
+        // в сумме давали 100%
+        PercentLanes user = delta[CPU_USER] - delta[CPU_GUEST];
+        user = (user > zero) ? user : zero;
+        PercentLanes nice = delta[CPU_NICE] - delta[CPU_GUEST_NICE];
+        nice = (nice > zero) ? nice : zero;
+        PercentLanes guest = delta[CPU_GUEST] + delta[CPU_GUEST_NICE];
+        PercentLanes busy = user + nice + guest + delta[CPU_SYSTEM] +
+                            delta[CPU_IRQ] + delta[CPU_SOFTIRQ] + delta[CPU_STEAL];
+        PercentLanes total = busy + delta[CPU_IDLE] + delta[CPU_IOWAIT];
+        // Пустой интервал даёт нули, а не деление на ноль
+        PercentLanes scale = 100.0 / ((total > one) ? total : one);
 
-    if (cpu_usage_percent_ < 0) {
-        oss << "CPU: N/A";
-    } else {
-        oss << "CPU " << count_cores_ << ": " << cpu_usage_percent_ << "%\n";
+        storeLanes(total, &ticks_[i]);
+        storeLanes(busy * scale, &percents_[COL_USAGE][i]);
+        storeLanes(user * scale, &percents_[COL_USER][i]);
+        storeLanes(nice * scale, &percents_[COL_NICE][i]);
+        storeLanes(delta[CPU_SYSTEM] * scale, &percents_[COL_SYSTEM][i]);
+        storeLanes(delta[CPU_IDLE] * scale, &percents_[COL_IDLE][i]);
+        storeLanes(delta[CPU_IOWAIT] * scale, &percents_[COL_IOWAIT][i]);
+        storeLanes(delta[CPU_IRQ] * scale, &percents_[COL_IRQ][i]);
+        storeLanes(delta[CPU_SOFTIRQ] * scale, &percents_[COL_SOFTIRQ][i]);
+        storeLanes(delta[CPU_STEAL] * scale, &percents_[COL_STEAL][i]);
+        storeLanes(guest * scale, &percents_[COL_GUEST][i]);
     }
+}
 
-    if (collect_per_core_ && !core_usage_percents_.empty()) {
-        oss << "  [";
-        for (size_t i = 0; i < core_usage_percents_.size(); ++i) {
-            if (i > 0) oss << ", ";
-            if (core_usage_percents_[i] < 0) {
-                oss << "N/A";
-            } else {
-                oss << "C" << i << ":" << core_usage_percents_[i];
+void CpuCollector::addRollups(MetricSnapshot& snapshot) {
+    // Крупные группы выше мелких: узлы, сокеты, ядра
+    for (int kind = GROUP_KINDS - 1; kind >= 0; --kind) {
+        CpuGroupKind group_kind = static_cast<CpuGroupKind>(kind);
+        std::size_t groups = topology_->groups(group_kind);
+        if ((rollups_ & (1u << kind)) == 0 || groups < 2) {
+            continue;
+        }
+        group_sums_.assign(groups * COL_COUNT, 0.0);
+        group_ticks_.assign(groups, 0.0);
+        group_cpus_.assign(groups, 0);
+        for (std::size_t i = 1; i < current_.rows; ++i) {
+            int group = (current_.present[i] && previous_.present[i]) ? topology_->group(group_kind, i - 1) : -1;
+            if (group < 0) {
+                continue;
             }
+            double* sums = &group_sums_[static_cast<std::size_t>(group) * COL_COUNT];
+            for (std::size_t column = 0; column < COL_COUNT; ++column) {
+                if (column != COL_CORES) {
+                    sums[column] += percents_[column][i] * ticks_[i];
+                }
+            }
+            group_ticks_[group] += ticks_[i];
+            ++group_cpus_[group];
+        }
+        for (std::size_t group = 0; group < groups; ++group) {
+            // Узел без CPU (только память) в сводку CPU не попадает
+            if (group_cpus_[group] == 0) {
+                continue;
+            }
+            double* row = snapshot.addRow(topology_->groupName(group_kind, group));
+            const double* sums = &group_sums_[group * COL_COUNT];
+            for (std::size_t column = 0; column < COL_COUNT; ++column) {
+                row[column] = (group_ticks_[group] > 0) ? sums[column] / group_ticks_[group] : 0.0;
+            }
+            row[COL_CORES] = group_cpus_[group];
         }
-        oss << "]\n";
     }
-
-    return oss.str();
 }
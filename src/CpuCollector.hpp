@@ -1,52 +1,85 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
+#include "CpuTopology.hpp"
 #include "Logger.hpp"
+#include "ProcReader.hpp"
 #include "IMetricCollector.hpp"
 
-struct CpuTimes {
-    std::uint64_t user = 0;
-    std::uint64_t nice = 0;
-    std::uint64_t system = 0;
-    std::uint64_t idle = 0;
-    std::uint64_t iowait = 0;
-    std::uint64_t irq = 0;
-    std::uint64_t softirq = 0;
-    std::uint64_t steal = 0;
-    std::uint64_t guest = 0;
-    std::uint64_t guest_nice = 0;
+// Поля строки cpu в /proc/stat в порядке следования
+enum CpuState {
+    CPU_USER, CPU_NICE, CPU_SYSTEM, CPU_IDLE, CPU_IOWAIT,
+    CPU_IRQ, CPU_SOFTIRQ, CPU_STEAL, CPU_GUEST, CPU_GUEST_NICE,
+    CPU_STATES
 };
 
-struct CpuStats {
-    CpuTimes total;
-    std::vector<CpuTimes> per_core;
-    bool has_total = false;
+// Сколько строк считается за один шаг SIMD; длина всех массивов кратна ему
+inline constexpr std::size_t kCpuLanes = 2;
+
+// Счётчики /proc/stat структурой массивов: state[s][row] — тики состояния s.
+// Строка 0 — общая "cpu", строка N + 1 — ядро N (номера ядер с пропусками
+// для выключенных не сдвигают остальные строки).
+struct CpuTimeArrays {
+    std::array<std::vector<std::uint64_t>, CPU_STATES> state;
+    std::vector<std::uint8_t> present;   // строка была в последнем чтении
+    std::size_t rows = 0;                // последняя заполненная строка + 1
+
+    std::size_t capacity() const { return present.size(); }
+    // Растит массивы до rows с округлением до kCpuLanes; новые ячейки — нули
+    void reserve(std::size_t rows);
 };
 
 class CpuCollector : public IMetricCollector {
 public:
-    explicit CpuCollector(bool collect_per_core, Logger& logger);
+    CpuCollector(bool collect_per_core, const std::string& proc_root, Logger& logger);
     void collect() override;
-    std::string getFormattedData() override;
+    SnapshotGuard snapshot() const override { return snapshots_.read(); }
+
+    // Добавляет строки-сводки по ядрам, сокетам и узлам NUMA (биты
+    // 1 << CpuGroupKind в kinds) по топологии из <sys_root>/devices/system.
+    // Разбиение, где всего одна группа, не выводится.
+    void enableRollups(const std::string& sys_root, unsigned kinds);
+
+    // Разбор /proc/stat; открыты для замеров в bench/
+    void parseCpuLine(std::string_view line, CpuTimeArrays& times, std::size_t row);
+    // Без per_core строки ядер только считаются; возвращает число ядер
+    std::size_t readCpuTimes(CpuTimeArrays& times, bool per_core);
 private:
-    double calculateCpuUsage(const CpuTimes& current, const CpuTimes& previous);
-    std::vector<double> calculatePerCoreUsage(
-        const std::vector<CpuTimes>& current_cores,
-        const std::vector<CpuTimes>& previous_cores
-    );
-    CpuTimes parseCpuLine(const std::string& line);
-    CpuStats readAllCpuCores();
+    // Доли состояний за интервал для строк [0, rows) из current_ и previous_
+    void computePercents(std::size_t rows);
+    // Средние по группам, взвешенные тиками строк
+    void addRollups(MetricSnapshot& snapshot);
 
     bool collect_per_core_;
     bool first_run_ = true;
-    
-    CpuTimes prev_total_;
-    double cpu_usage_percent_ = 0.0;
 
-    std::vector<CpuTimes> prev_cores_;
-    std::vector<double> core_usage_percents_;
+    ProcReader stat_reader_;
+    // Два буфера меняются местами после каждого тика, копирования нет
+    CpuTimeArrays current_;
+    CpuTimeArrays previous_;
+    // Результат по столбцам снимка, тоже структурой массивов
+    std::vector<std::vector<double>> percents_;
+    // Тики строки за интервал — её вес в сводках
+    std::vector<double> ticks_;
+    // "total", "cpu0", "cpu1"... по номеру строки; растёт вместе с массивами
+    std::vector<std::string> row_names_;
+
     std::uint32_t count_cores_;
 
+    unsigned rollups_ = 0;
+    std::unique_ptr<CpuTopology> topology_;
+    // present, с которым топология читалась последний раз: другой набор
+    // строк в /proc/stat означает hotplug
+    std::vector<std::uint8_t> topology_cpus_;
+    std::vector<double> group_sums_;   // группа × столбец
+    std::vector<double> group_ticks_;
+    std::vector<std::uint32_t> group_cpus_;
+
+    SnapshotBuffer<MetricSnapshot> snapshots_;
     Logger& logger_;
-};
\ No newline at end of file
+};
@@ -0,0 +1,133 @@
+#include "CpuTopology.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <string_view>
+#include <utility>
+#include <dirent.h>
+#include "ProcReader.hpp"
+
+namespace {
+// Файл sysfs из одного числа; false, если файла нет или в нём не число
+// (physical_package_id бывает -1)
+bool readNumber(const std::string& path, std::uint64_t& value) {
+    try {
+        ProcReader reader(path);
+        std::string_view text = reader.read();
+        return parseUint(text, value);
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+std::size_t parseDigits(std::string_view& s) {
+    std::size_t value = 0;
+    std::size_t i = 0;
+    for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        value = value * 10 + static_cast<std::size_t>(s[i] - '0');
+    }
+    s.remove_prefix(i);
+    return value;
+}
+
+// Список вида "0-3,8-11\n" в номера CPU
+std::vector<std::size_t> parseCpuRanges(std::string_view list) {
+    std::vector<std::size_t> cpus;
+    while (!list.empty() && list[0] >= '0' && list[0] <= '9') {
+        std::size_t first = parseDigits(list);
+        std::size_t last = first;
+        if (!list.empty() && list[0] == '-') {
+            list.remove_prefix(1);
+            last = parseDigits(list);
+        }
+        for (std::size_t cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (!list.empty() && list[0] == ',') {
+            list.remove_prefix(1);
+        }
+    }
+    return cpus;
+}
+}
+
+CpuTopology::CpuTopology(std::string sys_root) :
+sys_root_(std::move(sys_root)) {
+}
+
+void CpuTopology::reload(const std::vector<std::size_t>& cpus) {
+    std::size_t size = cpus.empty() ? 0 : *std::max_element(cpus.begin(), cpus.end()) + 1;
+    for (std::size_t kind = 0; kind < GROUP_KINDS; ++kind) {
+        group_of_cpu_[kind].assign(size, -1);
+        names_[kind].clear();
+    }
+
+    // Номера групп раздаются по возрастанию (сокет, ядро), чтобы строки
+    // не переставлялись между перезагрузками
+    std::vector<std::pair<std::uint64_t, std::uint64_t>> placement(size, {UINT64_MAX, UINT64_MAX});
+    std::map<std::pair<std::uint64_t, std::uint64_t>, int> cores;
+    std::map<std::uint64_t, int> sockets;
+    for (std::size_t cpu : cpus) {
+        std::string dir = sys_root_ + "/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+        std::uint64_t package = 0;
+        std::uint64_t core = 0;
+        if (!readNumber(dir + "physical_package_id", package) || !readNumber(dir + "core_id", core)) {
+            continue;
+        }
+        placement[cpu] = {package, core};
+        cores.emplace(placement[cpu], 0);
+        sockets.emplace(package, 0);
+    }
+    for (auto& [key, index] : cores) {
+        index = static_cast<int>(names_[GROUP_CORE].size());
+        names_[GROUP_CORE].push_back("socket" + std::to_string(key.first) + ".core" + std::to_string(key.second));
+    }
+    for (auto& [package, index] : sockets) {
+        index = static_cast<int>(names_[GROUP_SOCKET].size());
+        names_[GROUP_SOCKET].push_back("socket" + std::to_string(package));
+    }
+    for (std::size_t cpu : cpus) {
+        if (placement[cpu].first != UINT64_MAX) {
+            group_of_cpu_[GROUP_CORE][cpu] = cores[placement[cpu]];
+            group_of_cpu_[GROUP_SOCKET][cpu] = sockets[placement[cpu].first];
+        }
+    }
+
+    for (int node : listNumaNodes(sys_root_)) {
+        std::string path = sys_root_ + "/devices/system/node/node" + std::to_string(node) + "/cpulist";
+        std::vector<std::size_t> node_cpus;
+        try {
+            ProcReader reader(path);
+            node_cpus = parseCpuRanges(reader.read());
+        } catch (const std::exception&) {
+            continue;
+        }
+        int index = static_cast<int>(names_[GROUP_NODE].size());
+        names_[GROUP_NODE].push_back("node" + std::to_string(node));
+        for (std::size_t cpu : node_cpus) {
+            if (cpu < size) {
+                group_of_cpu_[GROUP_NODE][cpu] = index;
+            }
+        }
+    }
+}
+
+std::vector<int> listNumaNodes(const std::string& sys_root) {
+    std::vector<int> nodes;
+    DIR* dir = ::opendir((sys_root + "/devices/system/node").c_str());
+    if (dir == nullptr) {
+        return nodes;
+    }
+    while (dirent* entry = ::readdir(dir)) {
+        const char* name = entry->d_name;
+        if (std::strncmp(name, "node", 4) == 0 && name[4] >= '0' && name[4] <= '9') {
+            nodes.push_back(std::atoi(name + 4));
+        }
+    }
+    ::closedir(dir);
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Разбиения CPU на группы; бит 1 << kind — в маске включённых сводок
+enum CpuGroupKind { GROUP_CORE, GROUP_SOCKET, GROUP_NODE, GROUP_KINDS };
+
+// Где стоит каждый CPU: физическое ядро (SMT-соседи), сокет и узел NUMA.
+// Читается из <sys_root>/devices/system/cpu/cpuN/topology и
+// <sys_root>/devices/system/node/nodeM/cpulist. Дорого и нужно редко —
+// владелец перечитывает её только при изменении набора CPU.
+class CpuTopology {
+public:
+    explicit CpuTopology(std::string sys_root);
+
+    // Перечитывает расположение для перечисленных номеров CPU
+    void reload(const std::vector<std::size_t>& cpus);
+
+    // Номер группы CPU или -1, если sysfs его не описывает
+    int group(CpuGroupKind kind, std::size_t cpu) const {
+        const std::vector<int>& groups = group_of_cpu_[kind];
+        return (cpu < groups.size()) ? groups[cpu] : -1;
+    }
+    std::size_t groups(CpuGroupKind kind) const { return names_[kind].size(); }
+    // "socket0.core3", "socket1", "node0"
+    const std::string& groupName(CpuGroupKind kind, std::size_t group) const { return names_[kind][group]; }
+
+private:
+    std::string sys_root_;
+    std::array<std::vector<int>, GROUP_KINDS> group_of_cpu_;
+    std::array<std::vector<std::string>, GROUP_KINDS> names_;
+};
+
+// Номера узлов NUMA из <sys_root>/devices/system/node по возрастанию;
+// пусто, если ядро собрано без NUMA
+std::vector<int> listNumaNodes(const std::string& sys_root);
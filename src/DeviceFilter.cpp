@@ -0,0 +1,57 @@
+#include "DeviceFilter.hpp"
+#include <fnmatch.h>
+
+DeviceFilter::DeviceFilter(const std::string& include, const std::string& exclude) :
+include_(compile(include)),
+exclude_(compile(exclude)) {
+}
+
+std::vector<DeviceFilter::Pattern> DeviceFilter::compile(const std::string& list) {
+    std::vector<Pattern> patterns;
+    std::size_t start = 0;
+    while (start < list.size()) {
+        std::size_t comma = list.find(',', start);
+        if (comma == std::string::npos) {
+            comma = list.size();
+        }
+        std::string text = list.substr(start, comma - start);
+        start = comma + 1;
+        if (text.empty()) {
+            continue;
+        }
+        std::size_t special = text.find_first_of("*?[");
+        if (special == std::string::npos) {
+            patterns.push_back(Pattern{Pattern::EXACT, text});
+        } else if (special == text.size() - 1 && text.back() == '*') {
+            text.pop_back();
+            patterns.push_back(Pattern{Pattern::PREFIX, text});
+        } else {
+            patterns.push_back(Pattern{Pattern::GLOB, text});
+        }
+    }
+    return patterns;
+}
+
+bool DeviceFilter::matchesAny(const std::vector<Pattern>& patterns, std::string_view name) {
+    for (const Pattern& pattern : patterns) {
+        switch (pattern.kind) {
+        case Pattern::EXACT:
+            if (name == pattern.text) return true;
+            break;
+        case Pattern::PREFIX:
+            if (name.substr(0, pattern.text.size()) == pattern.text) return true;
+            break;
+        case Pattern::GLOB:
+            if (::fnmatch(pattern.text.c_str(), std::string(name).c_str(), 0) == 0) return true;
+            break;
+        }
+    }
+    return false;
+}
+
+bool DeviceFilter::accepts(std::string_view name) const {
+    if (!include_.empty() && !matchesAny(include_, name)) {
+        return false;
+    }
+    return !matchesAny(exclude_, name);
+}
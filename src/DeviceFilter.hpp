@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Отбор устройств по спискам шаблонов через запятую ("sd*,nvme0n1").
+// Шаблоны разбираются один раз при старте: точное имя и "префикс*"
+// сравниваются напрямую, остальное уходит в fnmatch(). Проверка нужна
+// только для нового имени — владелец кеширует ответ по слоту NameTable.
+class DeviceFilter {
+public:
+    DeviceFilter() = default;
+    DeviceFilter(const std::string& include, const std::string& exclude);
+
+    // Подходит под include (если он задан) и не подходит под exclude
+    bool accepts(std::string_view name) const;
+    // Имя явно названо в include — например, раздел, который иначе скрыт
+    bool includes(std::string_view name) const { return matchesAny(include_, name); }
+
+private:
+    struct Pattern {
+        enum Kind { EXACT, PREFIX, GLOB };
+        Kind kind;
+        std::string text;   // для PREFIX — без '*'
+    };
+
+    static std::vector<Pattern> compile(const std::string& list);
+    static bool matchesAny(const std::vector<Pattern>& patterns, std::string_view name);
+
+    std::vector<Pattern> include_;
+    std::vector<Pattern> exclude_;
+};
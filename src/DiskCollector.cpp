@@ -1,140 +1,244 @@
 #include "DiskCollector.hpp"
 #include <algorithm>
-#include <iomanip>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <cctype>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+// Порядок столбцов снимка
+enum DiskColumn { COL_READ_IOPS, COL_WRITE_IOPS, COL_READ_MIB_S, COL_WRITE_MIB_S, COL_UTIL,
+                  COL_READ_AWAIT, COL_WRITE_AWAIT, COL_QUEUE, COL_REQUEST_KB,
+                  COL_READ_MERGED, COL_WRITE_MERGED };
+
+// Секторы в /proc/diskstats всегда по 512 байт, какой бы ни был
+// логический сектор устройства (hw_sector_size) — так их считает ядро
+constexpr double kSectorBytes = 512.0;
+
+std::uint64_t counterDiff(std::uint64_t current, std::uint64_t previous) {
+    return (current > previous) ? current - previous : 0;
+}
+
+// Снимает с начала name символы, подходящие под pred; false — ни одного
+template <typename Pred>
+bool skipRun(std::string_view& name, Pred pred) {
+    std::size_t n = 0;
+    while (n < name.size() && pred(static_cast<unsigned char>(name[n]))) {
+        ++n;
+    }
+    name.remove_prefix(n);
+    return n > 0;
+}
+
+bool skipPrefix(std::string_view& name, std::string_view prefix) {
+    if (name.substr(0, prefix.size()) != prefix) {
+        return false;
+    }
+    name.remove_prefix(prefix.size());
+    return true;
+}
 
+bool skipDigits(std::string_view& name) {
+    return skipRun(name, [](unsigned char c) { return std::isdigit(c) != 0; });
+}
 
-DiskCollector::DiskCollector(std::chrono::milliseconds interval, Logger& logger) :
-interval_(interval), 
-first_run_(true), 
+// Имена разделов, которые ядро даёт дискам: sdb2, vda1, xvda1, hdc3,
+// nvme0n1p2, mmcblk0p1. Остальное (md0, dm-0, loop0, sr0, zram0, nbd0,
+// mmcblk0, nvme0n1) — целые устройства.
+bool isPartitionName(std::string_view name) {
+    for (std::string_view prefix : {"sd", "vd", "xvd", "hd"}) {
+        std::string_view rest = name;
+        if (skipPrefix(rest, prefix)) {
+            return skipRun(rest, [](unsigned char c) { return std::islower(c) != 0; }) &&
+                   skipDigits(rest) && rest.empty();
+        }
+    }
+    std::string_view rest = name;
+    if (skipPrefix(rest, "nvme")) {
+        return skipDigits(rest) && skipPrefix(rest, "n") && skipDigits(rest) &&
+               skipPrefix(rest, "p") && skipDigits(rest) && rest.empty();
+    }
+    if (skipPrefix(rest, "mmcblk")) {
+        return skipDigits(rest) && skipPrefix(rest, "p") && skipDigits(rest) && rest.empty();
+    }
+    return false;
+}
+}
+
+DiskCollector::DiskCollector(const std::string& proc_root, const std::string& sys_root, DeviceFilter filter,
+                             Logger& logger) :
+first_run_(true),
+diskstats_reader_(proc_root + "/diskstats"),
+sys_root_(sys_root),
+filter_(std::move(filter)),
+snapshots_(MetricSnapshot(MetricSource::DISK, {
+    MetricId::DISK_READ_IOPS, MetricId::DISK_WRITE_IOPS,
+    MetricId::DISK_READ_MIB_S, MetricId::DISK_WRITE_MIB_S, MetricId::DISK_UTIL_PERCENT,
+    MetricId::DISK_READ_AWAIT_MS, MetricId::DISK_WRITE_AWAIT_MS, MetricId::DISK_QUEUE_DEPTH,
+    MetricId::DISK_REQUEST_KB, MetricId::DISK_READ_MERGED_S, MetricId::DISK_WRITE_MERGED_S})),
 logger_(logger) {
     logger_.info("DiskCollector start.");
 }
 
-std::vector<DiskStats> readDiskStats() {
-    std::ifstream file("/proc/diskstats");
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open /proc/diskstats");
+bool DiskCollector::isPartition(std::string_view name) const {
+    // '/' в имени (cciss/c0d0) в sysfs записывается как '!'
+    std::string sys_name(name);
+    std::replace(sys_name.begin(), sys_name.end(), '/', '!');
+    if (::access((sys_root_ + "/block/" + sys_name).c_str(), F_OK) == 0) {
+        return false;
     }
-    std::vector<DiskStats> disks;
-    std::string line;
-
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::vector<std::string> tokens;
-        std::string token;
-        while (iss >> token) {
-            tokens.push_back(token);
-        }
+    if (::access((sys_root_ + "/class/block/" + sys_name).c_str(), F_OK) == 0) {
+        return true;
+    }
+    // В sysfs устройства нет (--proc-root с другой машины) — угадываем по имени
+    return isPartitionName(name);
+}
 
-        if (tokens.size() < 14) {
+bool DiskCollector::showSlot(std::uint32_t slot) {
+    SlotState& state = slot_state_[slot];
+    if (state == SLOT_UNKNOWN) {
+        // Раздел показываем, только если его явно назвали в include
+        std::string_view name = names_.name(slot);
+        bool show = filter_.accepts(name) && (!isPartition(name) || filter_.includes(name));
+        state = show ? SLOT_SHOWN : SLOT_HIDDEN;
+    }
+    return state == SLOT_SHOWN;
+}
+
+void readDiskStats(std::string_view text, NameTable& names, std::vector<DiskStats>& disks) {
+    std::size_t count = 0;
+    std::string_view line;
+
+    while (nextLine(text, line)) {
+        std::uint64_t major = 0;
+        std::uint64_t minor = 0;
+        if (!parseUint(line, major) || !parseUint(line, minor)) {
+            continue;
+        }
+        std::string_view name = nextToken(line);
+        if (name.empty()) {
             continue;
         }
 
-        const std::string& name = tokens[2];
-        if (std::isdigit(name.back())) {
-            if (name.find("nvme") == std::string::npos || name.find('p') != std::string::npos) {
-                continue;
+        // Поля 3..13; всё, что дальше (discard/flush), не используем
+        std::uint64_t fields[11];
+        bool valid = true;
+        for (std::uint64_t& field : fields) {
+            if (!parseUint(line, field)) {
+                valid = false;
+                break;
             }
         }
-
-        try {
-            DiskStats ds;
-            ds.name = name;
-            ds.reads = std::stoull(tokens[3]);
-            ds.reads_merged = std::stoull(tokens[4]);
-            ds.sectors_read = std::stoull(tokens[5]);
-            ds.read_time_ms = std::stoull(tokens[6]);
-            ds.writes = std::stoull(tokens[7]);
-            ds.writes_merged = std::stoull(tokens[8]);
-            ds.sectors_written = std::stoull(tokens[9]);
-            ds.write_time_ms = std::stoull(tokens[10]);
-            ds.io_time_ms = std::stoull(tokens[12]);      // поле 12 (индекс 12)
-            ds.weighted_time_ms = std::stoull(tokens[13]); // поле 13
-
-            disks.push_back(ds);
-        } catch (const std::exception&) {
+        if (!valid) {
             continue; // некорректные данные — пропускаем
         }
+
+        if (count == disks.size()) {
+            disks.emplace_back();
+        }
+        DiskStats& ds = disks[count++];
+        ds.slot = names.intern(name);
+        ds.reads = fields[0];
+        ds.reads_merged = fields[1];
+        ds.sectors_read = fields[2];
+        ds.read_time_ms = fields[3];
+        ds.writes = fields[4];
+        ds.writes_merged = fields[5];
+        ds.sectors_written = fields[6];
+        ds.write_time_ms = fields[7];
+        ds.io_time_ms = fields[9];        // поле 12 (индекс 12)
+        ds.weighted_time_ms = fields[10]; // поле 13
     }
+    disks.resize(count);
 
     if (disks.empty()) {
         throw std::runtime_error("No valid disk devices found in /proc/diskstats");
     }
-
-    return disks;
 }
 
 void DiskCollector::collect() {
 try {
-        std::vector<DiskStats> current = readDiskStats();
-
-        if (first_run_) {
-            prev_stats_ = current;
-            first_run_ = false;
-            current_metrics_.clear();
-            return;
+        ++tick_;
+        std::string_view text = diskstats_reader_.read();
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        readDiskStats(text, names_, current_stats_);
+        if (names_.slotCount() > prev_by_slot_.size()) {
+            prev_by_slot_.resize(names_.slotCount());
+            seen_tick_.resize(names_.slotCount(), 0);
+            slot_state_.resize(names_.slotCount(), SLOT_UNKNOWN);
         }
 
-        current_metrics_.clear();
-        double interval_sec = interval_.count() / 1000.0;
-        uint64_t interval_ms = interval_.count();
-
-        for (const auto& curr : current) {
-            // Найти prev с тем же именем
-            auto it = std::find_if(prev_stats_.begin(), prev_stats_.end(),
-                [&curr](const DiskStats& d) { return d.name == curr.name; });
-
-            if (it == prev_stats_.end()) {
-                continue; // новое устройство — пропускаем в этот раз
+        bool publish = !first_run_;
+        MetricSnapshot* snapshot = nullptr;
+        if (publish) {
+            snapshot = &snapshots_.beginWrite();
+            snapshot->beginRows();
+        }
+        // Скорости считаем по реально прошедшему времени, а не по заданному интервалу
+        double interval_sec = std::chrono::duration<double>(now - prev_time_).count();
+        double interval_ms = interval_sec * 1000.0;
+
+        for (const DiskStats& curr : current_stats_) {
+            // Прошлые счётчики есть, только если устройство было и в прошлом тике;
+            // новое устройство пропускаем в этот раз
+            if (publish && seen_tick_[curr.slot] + 1 == tick_ && showSlot(curr.slot)) {
+                const DiskStats& prev = prev_by_slot_[curr.slot];
+
+                uint64_t read_diff = counterDiff(curr.reads, prev.reads);
+                uint64_t write_diff = counterDiff(curr.writes, prev.writes);
+                uint64_t sectors_read_diff = counterDiff(curr.sectors_read, prev.sectors_read);
+                uint64_t sectors_written_diff = counterDiff(curr.sectors_written, prev.sectors_written);
+                uint64_t io_time_diff = counterDiff(curr.io_time_ms, prev.io_time_ms);
+                uint64_t read_time_diff = counterDiff(curr.read_time_ms, prev.read_time_ms);
+                uint64_t write_time_diff = counterDiff(curr.write_time_ms, prev.write_time_ms);
+                uint64_t weighted_diff = counterDiff(curr.weighted_time_ms, prev.weighted_time_ms);
+                uint64_t requests = read_diff + write_diff;
+
+                double* m = snapshot->addRow(names_.name(curr.slot));
+                m[COL_READ_IOPS] = (interval_sec > 0) ? (read_diff / interval_sec) : 0.0;
+                m[COL_WRITE_IOPS] = (interval_sec > 0) ? (write_diff / interval_sec) : 0.0;
+                m[COL_READ_MIB_S] = (interval_sec > 0) ? (sectors_read_diff * kSectorBytes / (1024*1024) / interval_sec) : 0.0;
+                m[COL_WRITE_MIB_S] = (interval_sec > 0) ? (sectors_written_diff * kSectorBytes / (1024*1024) / interval_sec) : 0.0;
+                m[COL_UTIL] = (interval_ms > 0) ? (static_cast<double>(io_time_diff) / interval_ms * 100.0) : 0.0;
+
+                // Ограничиваем utilization 100%
+                if (m[COL_UTIL] > 100.0) m[COL_UTIL] = 100.0;
+
+                // Как r_await, w_await, aqu-sz и areq-sz в iostat -x
+                m[COL_READ_AWAIT] = (read_diff > 0) ? static_cast<double>(read_time_diff) / read_diff : 0.0;
+                m[COL_WRITE_AWAIT] = (write_diff > 0) ? static_cast<double>(write_time_diff) / write_diff : 0.0;
+                m[COL_QUEUE] = (interval_ms > 0) ? static_cast<double>(weighted_diff) / interval_ms : 0.0;
+                m[COL_REQUEST_KB] = (requests > 0)
+                    ? (sectors_read_diff + sectors_written_diff) * kSectorBytes / 1024.0 / requests : 0.0;
+                m[COL_READ_MERGED] = (interval_sec > 0) ? counterDiff(curr.reads_merged, prev.reads_merged) / interval_sec : 0.0;
+                m[COL_WRITE_MERGED] = (interval_sec > 0) ? counterDiff(curr.writes_merged, prev.writes_merged) / interval_sec : 0.0;
             }
-
-            const DiskStats& prev = *it;
-
-            uint64_t read_diff = (curr.reads > prev.reads) ? (curr.reads - prev.reads) : 0;
-            uint64_t write_diff = (curr.writes > prev.writes) ? (curr.writes - prev.writes) : 0;
-            uint64_t sectors_read_diff = (curr.sectors_read > prev.sectors_read) ? (curr.sectors_read - prev.sectors_read) : 0;
-            uint64_t sectors_written_diff = (curr.sectors_written > prev.sectors_written) ? (curr.sectors_written - prev.sectors_written) : 0;
-            uint64_t io_time_diff = (curr.io_time_ms > prev.io_time_ms) ? (curr.io_time_ms - prev.io_time_ms) : 0;
-
-            DiskMetrics m;
-            m.name = curr.name;
-            m.read_iops = (interval_sec > 0) ? (read_diff / interval_sec) : 0.0;
-            m.write_iops = (interval_sec > 0) ? (write_diff / interval_sec) : 0.0;
-            m.read_mib_s = (interval_sec > 0) ? (sectors_read_diff * 512.0 / (1024*1024) / interval_sec) : 0.0;
-            m.write_mib_s = (interval_sec > 0) ? (sectors_written_diff * 512.0 / (1024*1024) / interval_sec) : 0.0;
-            m.utilization_percent = (interval_ms > 0) ? (static_cast<double>(io_time_diff) / interval_ms * 100.0) : 0.0;
-
-            // Ограничиваем utilization 100%
-            if (m.utilization_percent > 100.0) m.utilization_percent = 100.0;
-
-            current_metrics_.push_back(m);
+            prev_by_slot_[curr.slot] = curr;
+            seen_tick_[curr.slot] = tick_;
+        }
+        if (publish) {
+            snapshot->endRows(now);
+            snapshots_.publish();
         }
 
-        prev_stats_ = std::move(current);
+        // Устройства, пропавшие из файла, освобождают слоты
+        for (std::uint32_t slot : active_slots_) {
+            if (seen_tick_[slot] != tick_) {
+                names_.release(slot);
+                slot_state_[slot] = SLOT_UNKNOWN;
+            }
+        }
+        active_slots_.clear();
+        for (const DiskStats& curr : current_stats_) {
+            active_slots_.push_back(curr.slot);
+        }
+        prev_time_ = now;
+        first_run_ = false;
 
     } catch (const std::exception& e) {
-        current_metrics_.clear();
-        prev_stats_.clear();
+        MetricSnapshot& snapshot = snapshots_.beginWrite();
+        snapshot.beginRows();
+        snapshot.endRows(std::chrono::steady_clock::now());
+        snapshots_.publish();
         first_run_ = true;
     }
 }
-
-std::string DiskCollector::getFormattedData() {
-    if (current_metrics_.empty()) {
-        return "Disk: N/A";
-    }
-
-    std::ostringstream oss;
-    oss << "Disk IO:\n";
-    for (const auto& m : current_metrics_) {
-        oss << "  " << m.name << ": "
-            << std::fixed << std::setprecision(1)
-            << "R " << m.read_mib_s << " MiB/s, "
-            << "W " << m.write_mib_s << " MiB/s, "
-            << "Util " << m.utilization_percent << "%\n";
-    }
-    return oss.str();
-}
@@ -2,12 +2,17 @@
 
 #include <cstdint>
 #include <chrono>
+#include <string>
+#include <string_view>
 #include <vector>
+#include "DeviceFilter.hpp"
 #include "Logger.hpp"
+#include "NameTable.hpp"
+#include "ProcReader.hpp"
 #include "IMetricCollector.hpp"
 
 struct DiskStats {
-    std::string name;
+    std::uint32_t slot = 0;            // номер имени в NameTable
     std::uint64_t reads = 0;
     std::uint64_t reads_merged = 0;
     std::uint64_t sectors_read = 0;
@@ -20,25 +25,40 @@ struct DiskStats {
     std::uint64_t weighted_time_ms = 0; // поле 13 — для расчёта очереди (опционально)
 };
 
-struct DiskMetrics {
-    std::string name;
-    float read_iops = 0.0;
-    float write_iops = 0.0;
-    float read_mib_s = 0.0;
-    float write_mib_s = 0.0;
-    float utilization_percent = 0.0; // io_time_diff / interval_ms * 100%
-};
+// Разбирает текст /proc/diskstats в disks (в порядке файла), переиспользуя уже
+// выделенные элементы. Имена устройств интернируются в names. Разделы и
+// прочие устройства не отсеиваются — это решает DiskCollector по слоту.
+void readDiskStats(std::string_view text, NameTable& names, std::vector<DiskStats>& disks);
 
 class DiskCollector : public IMetricCollector {
 public:
-    explicit DiskCollector(std::chrono::milliseconds interval, Logger& logger);
+    // sys_root — где искать block/ для отделения дисков от разделов;
+    // filter отбирает устройства по имени
+    DiskCollector(const std::string& proc_root, const std::string& sys_root, DeviceFilter filter, Logger& logger);
     void collect() override;
-    std::string getFormattedData() override;
+    SnapshotGuard snapshot() const override { return snapshots_.read(); }
 private:
-    std::chrono::milliseconds interval_;
+    enum SlotState : std::uint8_t { SLOT_UNKNOWN, SLOT_SHOWN, SLOT_HIDDEN };
+
+    // Показывать ли устройство слота; решается один раз, пока слот занят
+    bool showSlot(std::uint32_t slot);
+    bool isPartition(std::string_view name) const;
+
     bool first_run_;
-    std::vector<DiskStats> prev_stats_;
-    std::vector<DiskMetrics> current_metrics_;
-    
+    // Монотонное время, когда был прочитан предыдущий снимок счётчиков
+    std::chrono::steady_clock::time_point prev_time_;
+    ProcReader diskstats_reader_;
+    NameTable names_;
+    std::vector<DiskStats> current_stats_;
+    // Массивы по номеру слота: прошлые счётчики и тик, в котором устройство было в файле
+    std::vector<DiskStats> prev_by_slot_;
+    std::vector<std::uint64_t> seen_tick_;
+    std::vector<SlotState> slot_state_;
+    // Слоты из прошлого удачного тика — чтобы освободить пропавшие устройства
+    std::vector<std::uint32_t> active_slots_;
+    std::uint64_t tick_ = 0;
+    std::string sys_root_;
+    DeviceFilter filter_;
+    SnapshotBuffer<MetricSnapshot> snapshots_;
     Logger& logger_;
 };
\ No newline at end of file
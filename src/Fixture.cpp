@@ -0,0 +1,315 @@
+#include "Fixture.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CpuCollector.hpp"
+#include "DiskCollector.hpp"
+#include "MemoryCollector.hpp"
+#include "NetCollector.hpp"
+#include "ProcReader.hpp"
+
+namespace {
+void makeDir(const std::string& path) {
+    if (::mkdir(path.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("Cannot create directory " + path);
+    }
+}
+
+std::string frameDir(const std::string& dir, std::size_t frame) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "/%06zu", frame);
+    return dir + name;
+}
+
+// Каталог кадра с подкаталогом net/
+std::string makeFrameDir(const std::string& dir, std::size_t frame) {
+    std::string path = frameDir(dir, frame);
+    makeDir(path);
+    makeDir(path + "/net");
+    return path;
+}
+
+void writeAll(int fd, std::string_view data, const std::string& path) {
+    std::size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = ::pwrite(fd, data.data() + done, data.size() - done, static_cast<off_t>(done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot write " + path);
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(data.size())) != 0) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+void writeFile(const std::string& path, std::string_view data) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot create " + path);
+    }
+    try {
+        writeAll(fd, data, path);
+    } catch (...) {
+        ::close(fd);
+        throw;
+    }
+    ::close(fd);
+}
+
+bool fileExists(const std::string& path) {
+    struct stat st{};
+    return ::stat(path.c_str(), &st) == 0;
+}
+
+// Детерминированный генератор (xorshift64), чтобы фикстура с тем же seed
+// всегда была одинаковой
+class Random {
+public:
+    explicit Random(std::uint64_t seed) : state_(seed ? seed : 1) {}
+    std::uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+    std::uint64_t below(std::uint64_t limit) { return next() % limit; }
+
+private:
+    std::uint64_t state_;
+};
+
+void appendField(std::string& out, std::uint64_t value) {
+    out += ' ';
+    out += std::to_string(value);
+}
+
+// Имя диска: половина sdX (sda..sdz, sdaa..), половина nvmeNn1
+std::string diskName(std::size_t i) {
+    if (i % 2 == 1) {
+        return "nvme" + std::to_string(i / 2) + "n1";
+    }
+    std::size_t n = i / 2;
+    std::string suffix;
+    do {
+        suffix.insert(suffix.begin(), static_cast<char>('a' + n % 26));
+        n = n / 26;
+    } while (n-- > 0);
+    return "sd" + suffix;
+}
+}
+
+void captureFixture(const std::string& dir, const std::string& proc_root,
+                    std::size_t frames, std::chrono::milliseconds interval) {
+    makeDir(dir);
+    std::vector<std::unique_ptr<ProcReader>> readers;
+    for (const char* file : kFixtureFiles) {
+        readers.push_back(std::make_unique<ProcReader>(proc_root + "/" + file));
+    }
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now();
+    for (std::size_t frame = 0; frame < frames; ++frame) {
+        if (frame > 0) {
+            deadline += interval;
+            std::this_thread::sleep_until(deadline);
+        }
+        std::string path = makeFrameDir(dir, frame);
+        for (std::size_t i = 0; i < readers.size(); ++i) {
+            writeFile(path + "/" + kFixtureFiles[i], readers[i]->read());
+        }
+    }
+}
+
+void generateFixture(const std::string& dir, const SyntheticFixtureSpec& spec) {
+    makeDir(dir);
+    Random random(spec.seed);
+
+    // Скорость роста каждого счётчика постоянна, значения в кадре f — base + f * rate
+    std::vector<std::uint64_t> cpu_rate(spec.cpus * 10);
+    for (std::uint64_t& rate : cpu_rate) {
+        rate = random.below(100);
+    }
+    std::vector<std::uint64_t> disk_rate(spec.disks * 17);
+    for (std::uint64_t& rate : disk_rate) {
+        rate = random.below(5000);
+    }
+    std::vector<std::uint64_t> net_rate(spec.interfaces * 16);
+    for (std::uint64_t& rate : net_rate) {
+        rate = random.below(1000000);
+    }
+    std::uint64_t base = 1000000;
+
+    std::string text;
+    for (std::size_t frame = 0; frame < spec.frames; ++frame) {
+        std::string path = makeFrameDir(dir, frame);
+
+        text.clear();
+        std::uint64_t total[10] = {};
+        for (std::size_t cpu = 0; cpu < spec.cpus; ++cpu) {
+            for (std::size_t f = 0; f < 10; ++f) {
+                // guest и guest_nice обычно нули
+                total[f] += (f < 8) ? base + frame * cpu_rate[cpu * 10 + f] : 0;
+            }
+        }
+        text += "cpu ";
+        for (std::uint64_t value : total) {
+            appendField(text, value);
+        }
+        text += '\n';
+        for (std::size_t cpu = 0; cpu < spec.cpus; ++cpu) {
+            text += "cpu" + std::to_string(cpu);
+            for (std::size_t f = 0; f < 10; ++f) {
+                appendField(text, (f < 8) ? base + frame * cpu_rate[cpu * 10 + f] : 0);
+            }
+            text += '\n';
+        }
+        text += "intr " + std::to_string(base * 100 + frame * 12345);
+        for (std::size_t i = 0; i < 256; ++i) {
+            appendField(text, i % 7 == 0 ? base + frame * i : 0);
+        }
+        text += "\nctxt " + std::to_string(base * 50 + frame * 9876) +
+                "\nbtime 1700000000\nprocesses " + std::to_string(10000 + frame * 3) +
+                "\nprocs_running 3\nprocs_blocked 0\nsoftirq " + std::to_string(base + frame * 77) +
+                " 0 1 2 3 4 5 6 7 8 9\n";
+        writeFile(path + "/stat", text);
+
+        std::uint64_t mem_total = 64ull * spec.cpus * 1024 * 1024;
+        std::uint64_t available = mem_total / 2 + (frame % 16) * 1024;
+        static const char* const kMeminfoKeys[] = {
+            "Buffers", "Cached", "SwapCached", "Active", "Inactive", "Active(anon)", "Inactive(anon)",
+            "Active(file)", "Inactive(file)", "Unevictable", "Mlocked", "Dirty", "Writeback",
+            "AnonPages", "Mapped", "Shmem", "KReclaimable", "Slab", "SReclaimable", "SUnreclaim",
+            "KernelStack", "PageTables", "NFS_Unstable", "Bounce", "WritebackTmp", "CommitLimit",
+            "Committed_AS", "VmallocTotal", "VmallocUsed", "VmallocChunk", "Percpu",
+            "HardwareCorrupted", "AnonHugePages", "ShmemHugePages", "ShmemPmdMapped",
+            "FileHugePages", "FilePmdMapped", "HugePages_Total", "HugePages_Free",
+            "HugePages_Rsvd", "HugePages_Surp", "Hugepagesize", "Hugetlb", "DirectMap4k",
+            "DirectMap2M", "DirectMap1G"};
+        char line[96];
+        text.clear();
+        std::snprintf(line, sizeof(line), "MemTotal:       %14llu kB\n", static_cast<unsigned long long>(mem_total));
+        text += line;
+        std::snprintf(line, sizeof(line), "MemFree:        %14llu kB\n", static_cast<unsigned long long>(available / 2));
+        text += line;
+        std::snprintf(line, sizeof(line), "MemAvailable:   %14llu kB\n", static_cast<unsigned long long>(available));
+        text += line;
+        for (std::size_t i = 0; i < sizeof(kMeminfoKeys) / sizeof(kMeminfoKeys[0]); ++i) {
+            std::snprintf(line, sizeof(line), "%-16s%14llu kB\n", (std::string(kMeminfoKeys[i]) + ":").c_str(),
+                          static_cast<unsigned long long>(base + frame * i));
+            text += line;
+            if (i == 3) {
+                std::snprintf(line, sizeof(line), "SwapTotal:      %14llu kB\nSwapFree:       %14llu kB\n",
+                              static_cast<unsigned long long>(mem_total / 8),
+                              static_cast<unsigned long long>(mem_total / 8 - frame * 64));
+                text += line;
+            }
+        }
+        writeFile(path + "/meminfo", text);
+
+        text.clear();
+        for (std::size_t disk = 0; disk < spec.disks; ++disk) {
+            std::string name = diskName(disk);
+            bool nvme = disk % 2 == 1;
+            for (int partition = 0; partition < 2; ++partition) {
+                std::snprintf(line, sizeof(line), "%4u %7zu %s%s", nvme ? 259u : 8u,
+                              disk * 16 + static_cast<std::size_t>(partition), name.c_str(),
+                              partition == 0 ? "" : (nvme ? "p1" : "1"));
+                text += line;
+                for (std::size_t f = 0; f < 17; ++f) {
+                    appendField(text, (base + frame * disk_rate[disk * 17 + f]) >> partition);
+                }
+                text += '\n';
+            }
+        }
+        writeFile(path + "/diskstats", text);
+
+        text = "Inter-|   Receive                                                |  Transmit\n"
+               " face |bytes    packets errs drop fifo frame compressed multicast|"
+               "bytes    packets errs drop fifo colls carrier compressed\n";
+        for (std::size_t iface = 0; iface < spec.interfaces; ++iface) {
+            std::snprintf(line, sizeof(line), "%6s:", ("eth" + std::to_string(iface)).c_str());
+            text += line;
+            for (std::size_t f = 0; f < 16; ++f) {
+                appendField(text, base + frame * net_rate[iface * 16 + f]);
+            }
+            text += '\n';
+        }
+        writeFile(path + "/net/dev", text);
+    }
+}
+
+FixtureReplayStats replayFixture(const std::string& dir, std::size_t rounds,
+                                 bool per_core, Logger& logger) {
+    // Все кадры — в память, чтобы замер не зависел от диска
+    std::vector<std::array<std::string, kFixtureFiles.size()>> frames;
+    while (fileExists(frameDir(dir, frames.size()) + "/stat")) {
+        std::string path = frameDir(dir, frames.size());
+        frames.emplace_back();
+        for (std::size_t i = 0; i < kFixtureFiles.size(); ++i) {
+            ProcReader reader(path + "/" + kFixtureFiles[i]);
+            std::string_view data = reader.read();
+            frames.back()[i].assign(data.data(), data.size());
+        }
+    }
+    if (frames.empty()) {
+        throw std::runtime_error("No fixture frames in " + dir);
+    }
+
+    std::string staging = dir + "/.replay";
+    makeDir(staging);
+    makeDir(staging + "/net");
+    std::array<int, kFixtureFiles.size()> fds;
+    fds.fill(-1);
+    std::vector<std::unique_ptr<IMetricCollector>> collectors;
+    FixtureReplayStats stats;
+    try {
+        for (std::size_t i = 0; i < kFixtureFiles.size(); ++i) {
+            std::string path = staging + "/" + kFixtureFiles[i];
+            fds[i] = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fds[i] < 0) {
+                throw std::runtime_error("Cannot create " + path);
+            }
+        }
+
+        // Порядок как в kFixtureFiles
+        collectors.push_back(std::make_unique<CpuCollector>(per_core, staging, logger));
+        collectors.push_back(std::make_unique<MemoryCollector>(staging, logger));
+        collectors.push_back(std::make_unique<DiskCollector>(staging, "/sys", DeviceFilter(), logger));
+        collectors.push_back(std::make_unique<NetCollector>(staging, NetBackend::PROC, DeviceFilter("", "lo"), logger));
+
+        for (std::size_t round = 0; round < rounds; ++round) {
+            for (const std::array<std::string, kFixtureFiles.size()>& frame : frames) {
+                for (std::size_t i = 0; i < collectors.size(); ++i) {
+                    // Файл переписывается на месте: коллектор перечитает его через свой дескриптор
+                    writeAll(fds[i], frame[i], kFixtureFiles[i]);
+                    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                    collectors[i]->collect();
+                    stats.collect_time[i] += std::chrono::steady_clock::now() - start;
+                    stats.bytes += frame[i].size();
+                }
+                ++stats.frames;
+            }
+        }
+    } catch (...) {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                ::close(fd);
+            }
+        }
+        throw;
+    }
+    for (int fd : fds) {
+        ::close(fd);
+    }
+    return stats;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include "Logger.hpp"
+
+// Фикстура — последовательность снимков файлов /proc, которые читают коллекторы:
+//
+//   <dir>/000000/stat, meminfo, diskstats, net/dev
+//   <dir>/000001/...
+//
+// Её можно снять с живой машины или сгенерировать, а потом прогнать через
+// настоящие коллекторы с максимальной скоростью — разбор меряется одинаково
+// на любой машине.
+
+// Файлы одного кадра относительно корня /proc
+constexpr std::array<const char*, 4> kFixtureFiles = {"stat", "meminfo", "diskstats", "net/dev"};
+
+// Снимает frames кадров из proc_root с паузой interval
+void captureFixture(const std::string& dir, const std::string& proc_root,
+                    std::size_t frames, std::chrono::milliseconds interval);
+
+struct SyntheticFixtureSpec {
+    std::size_t frames = 10;
+    std::size_t cpus = 512;
+    std::size_t disks = 500;
+    std::size_t interfaces = 2000;
+    std::uint64_t seed = 1;
+};
+
+// Пишет синтетическую фикстуру: счётчики растут от кадра к кадру, у каждого
+// диска есть раздел (его коллектор должен отбросить)
+void generateFixture(const std::string& dir, const SyntheticFixtureSpec& spec);
+
+struct FixtureReplayStats {
+    std::size_t frames = 0;                         // сколько кадров разобрано
+    std::uint64_t bytes = 0;                        // сколько байт /proc прочитано
+    std::array<std::chrono::nanoseconds, 4> collect_time{};  // по коллекторам, порядок kFixtureFiles
+};
+
+// Прогоняет кадры фикстуры rounds раз через CpuCollector, MemoryCollector,
+// DiskCollector и NetCollector. Кадр подкладывается в <dir>/.replay через
+// уже открытые коллекторами файлы; в замер входит только collect().
+FixtureReplayStats replayFixture(const std::string& dir, std::size_t rounds,
+                                 bool per_core, Logger& logger);
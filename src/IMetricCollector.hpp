@@ -1,10 +1,17 @@
 #pragma once
 
-#include <string>
+#include "MetricSnapshot.hpp"
+#include "SnapshotBuffer.hpp"
+
+using SnapshotGuard = SnapshotBuffer<MetricSnapshot>::ReadGuard;
 
 class IMetricCollector {
 public:
+    // Не должен вызываться параллельно сам с собой
     virtual void collect() = 0;
-    virtual std::string getFormattedData() = 0;
+    // Последний опубликованный снимок. Можно звать из любого потока и в
+    // любой момент, в том числе во время collect(); текст из снимка
+    // строят только потребители.
+    virtual SnapshotGuard snapshot() const = 0;
     virtual ~IMetricCollector() = default;
-};
\ No newline at end of file
+};
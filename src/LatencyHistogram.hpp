@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Гистограмма длительностей с корзинами по степеням двойки (в наносекундах):
+// корзина b хранит значения из [2^b, 2^(b+1)). Запись — два relaxed
+// fetch_add без блокировок, так что её можно звать из любого потока прямо
+// на горячем пути. Счётчики только растут; читатель берёт копию через
+// load() и сам вычитает прошлую, чтобы получить картину за интервал.
+class LatencyHistogram {
+public:
+    static constexpr std::size_t kBuckets = 64;
+
+    struct Counts {
+        std::array<std::uint64_t, kBuckets> buckets{};
+        std::uint64_t sum_ns = 0;
+
+        std::uint64_t total() const {
+            std::uint64_t result = 0;
+            for (std::uint64_t count : buckets) {
+                result += count;
+            }
+            return result;
+        }
+        // Верхняя граница корзины, в которую попал квантиль q (0..1); 0, если пусто
+        std::uint64_t quantileNs(double q) const {
+            std::uint64_t rank = static_cast<std::uint64_t>(q * static_cast<double>(total()));
+            std::uint64_t seen = 0;
+            for (std::size_t b = 0; b < kBuckets; ++b) {
+                seen += buckets[b];
+                if (buckets[b] > 0 && seen > rank) {
+                    return upperBound(b);
+                }
+            }
+            return maxNs();
+        }
+        std::uint64_t maxNs() const {
+            for (std::size_t b = kBuckets; b-- > 0;) {
+                if (buckets[b] > 0) {
+                    return upperBound(b);
+                }
+            }
+            return 0;
+        }
+        // Разность с более ранней копией того же счётчика
+        Counts since(const Counts& earlier) const {
+            Counts diff;
+            for (std::size_t b = 0; b < kBuckets; ++b) {
+                diff.buckets[b] = buckets[b] - earlier.buckets[b];
+            }
+            diff.sum_ns = sum_ns - earlier.sum_ns;
+            return diff;
+        }
+    };
+
+    LatencyHistogram() {
+        for (std::atomic<std::uint64_t>& bucket : buckets_) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(std::uint64_t ns) {
+        std::size_t bucket = 63 - static_cast<std::size_t>(__builtin_clzll(ns | 1));
+        buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+        sum_ns_.fetch_add(ns, std::memory_order_relaxed);
+    }
+    void record(std::chrono::steady_clock::duration elapsed) {
+        std::int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        record(static_cast<std::uint64_t>(ns > 0 ? ns : 0));
+    }
+
+    // Корзины читаются по одной, так что копия согласована лишь приблизительно
+    Counts load() const {
+        Counts counts;
+        for (std::size_t b = 0; b < kBuckets; ++b) {
+            counts.buckets[b] = buckets_[b].load(std::memory_order_relaxed);
+        }
+        counts.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+        return counts;
+    }
+
+private:
+    static std::uint64_t upperBound(std::size_t bucket) {
+        return (bucket >= 63) ? UINT64_MAX : (std::uint64_t{2} << bucket);
+    }
+
+    std::array<std::atomic<std::uint64_t>, kBuckets> buckets_;
+    std::atomic<std::uint64_t> sum_ns_{0};
+};
@@ -1,16 +1,34 @@
 #include "Logger.hpp"
 
+#include <cerrno>
 #include <chrono>
-#include <iomanip>
-#include <sstream>
 #include <ctime>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
-Logger::Logger(const std::string& filename, Level min_level) :
-min_level_(min_level) {
-    file_.open(filename);
+namespace {
+// Сколько записей писатель отдаёт в один writev()
+constexpr std::size_t kMaxBatch = 64;
+// Начальная ёмкость строки в слоте кольца; длинные строки растят её один раз
+constexpr std::size_t kRecordReserve = 256;
+
+void writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += n;
+        size -= static_cast<std::size_t>(n);
+    }
+}
 }
 
-std::string levelToString(Logger::Level level) {
+const char* levelToString(Logger::Level level) {
     switch (level) {
     case Logger::Level::DEBUG:      
         return "DEBUG";
@@ -30,30 +48,223 @@ std::string levelToString(Logger::Level level) {
     }
 }
 
-std::string getCurrentTimestamp() {
+// Дописывает "YYYY-MM-DD HH:MM:SS.mmm". Часть до секунд форматируется
+// через strftime только раз в секунду и кешируется в каждом потоке.
+void appendTimestamp(std::string& out) {
+    thread_local std::time_t cached_second = -1;
+    thread_local char cached_prefix[32];
+    thread_local std::size_t cached_length = 0;
+
     const auto now = std::chrono::system_clock::now();
-    const auto now_time_t = std::chrono::system_clock::to_time_t(now);
-    
-    std::tm tm{};
-    localtime_r(&now_time_t, &tm);
+    const std::time_t now_time_t = std::chrono::system_clock::to_time_t(now);
+    if (now_time_t != cached_second) {
+        std::tm tm{};
+        localtime_r(&now_time_t, &tm);
+        cached_length = std::strftime(cached_prefix, sizeof(cached_prefix), "%Y-%m-%d %H:%M:%S", &tm);
+        cached_second = now_time_t;
+    }
 
     const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
         now.time_since_epoch()
-    ) % 1000;
+    ).count() % 1000;
+
+    out.append(cached_prefix, cached_length);
+    const char millis[4] = {'.', static_cast<char>('0' + ms / 100),
+                            static_cast<char>('0' + ms / 10 % 10),
+                            static_cast<char>('0' + ms % 10)};
+    out.append(millis, sizeof(millis));
+}
+
+void formatRecord(std::string& out, Logger::Level level, const std::string& message) {
+    out.clear();
+    out += '[';
+    appendTimestamp(out);
+    out += "] ";
+    out += levelToString(level);
+    out += ": ";
+    out += message;
+    out += '\n';
+}
+
+Logger::Logger(const std::string& filename, Level min_level) :
+min_level_(min_level) {
+    fd_ = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+}
+
+Logger::Logger(const std::string& filename, Level min_level, const AsyncOptions& options) :
+Logger(filename, min_level) {
+    options_ = options;
+    std::size_t capacity = 2;
+    while (capacity < options_.capacity) {
+        capacity <<= 1;
+    }
+    options_.capacity = capacity;
+    mask_ = capacity - 1;
 
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S")
-        << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    return oss.str();
+    ring_ = std::make_unique<Record[]>(capacity);
+    for (std::size_t i = 0; i < capacity; ++i) {
+        ring_[i].sequence.store(i, std::memory_order_relaxed);
+        ring_[i].text.reserve(kRecordReserve);
+    }
+    async_ = true;
+    if (fd_ >= 0) {
+        writer_ = std::thread([this] { writerLoop(); });
+    }
+}
+
+Logger::~Logger() {
+    if (writer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_.store(true);
+        }
+        wake_.notify_one();
+        writer_.join();
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
 }
 
 void Logger::log(Level level, const std::string& message) {
-    if (!file_.is_open()) return;
-    std::lock_guard<std::mutex> lock(mutex_);
-    file_ << "[" << getCurrentTimestamp() << "] "
-          << levelToString(level) << ": "
-          << message << "\n";
-    file_.flush();
+    if (fd_ < 0) return;
+
+    if (!async_) {
+        thread_local std::string line;
+        formatRecord(line, level, message);
+        std::lock_guard<std::mutex> lock(mutex_);
+        writeAll(fd_, line.data(), line.size());
+        return;
+    }
+
+    while (!tryPush(level, message)) {
+        if (options_.overflow == OverflowPolicy::DROP) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        // BLOCK: будим писателя и ждём, пока он освободит место
+        requestFlush();
+        std::this_thread::yield();
+    }
+}
+
+// Ограниченная MPSC-очередь на номерах последовательности (схема Вьюкова):
+// слот свободен для позиции pos, когда его sequence == pos, и готов к чтению,
+// когда sequence == pos + 1.
+bool Logger::tryPush(Level level, const std::string& message) {
+    std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Record* record = nullptr;
+    while (true) {
+        record = &ring_[pos & mask_];
+        std::size_t sequence = record->sequence.load(std::memory_order_acquire);
+        std::intptr_t diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false; // кольцо заполнено
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    formatRecord(record->text, level, message);
+    record->sequence.store(pos + 1, std::memory_order_release);
+
+    // ERROR пишем сразу; кроме того, будим писателя каждые пол-кольца
+    std::size_t half = (mask_ + 1) / 2;
+    if (level == Level::ERROR || ((pos + 1) & (half - 1)) == 0) {
+        requestFlush();
+    }
+    return true;
+}
+
+void Logger::requestFlush() {
+    flush_requested_.store(true, std::memory_order_release);
+    {
+        // Пустая секция под мьютексом, чтобы не потерять пробуждение
+        std::lock_guard<std::mutex> lock(mutex_);
+    }
+    wake_.notify_one();
+}
+
+std::size_t Logger::drainBatch() {
+    iovec iov[kMaxBatch];
+    std::size_t count = 0;
+    std::size_t pos = dequeue_pos_;
+    while (count < kMaxBatch) {
+        Record& record = ring_[(pos + count) & mask_];
+        if (record.sequence.load(std::memory_order_acquire) != pos + count + 1) {
+            break;
+        }
+        iov[count].iov_base = record.text.data();
+        iov[count].iov_len = record.text.size();
+        ++count;
+    }
+    if (count == 0) {
+        return 0;
+    }
+
+    iovec* current = iov;
+    std::size_t remaining = count;
+    while (remaining > 0) {
+        ssize_t n = ::writev(fd_, current, static_cast<int>(remaining));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        // Частичная запись: пропускаем целиком записанные буферы
+        std::size_t written = static_cast<std::size_t>(n);
+        while (remaining > 0 && written >= current->iov_len) {
+            written -= current->iov_len;
+            ++current;
+            --remaining;
+        }
+        if (remaining > 0) {
+            current->iov_base = static_cast<char*>(current->iov_base) + written;
+            current->iov_len -= written;
+        }
+    }
+
+    // Слоты освобождаются только после writev — iov указывал прямо в них
+    for (std::size_t i = 0; i < count; ++i) {
+        ring_[(pos + i) & mask_].sequence.store(pos + i + mask_ + 1, std::memory_order_release);
+    }
+    dequeue_pos_ = pos + count;
+    return count;
+}
+
+void Logger::writerLoop() {
+    std::string notice;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait_for(lock, options_.flush_interval, [this] {
+                return stop_.load() || flush_requested_.load(std::memory_order_acquire);
+            });
+        }
+        flush_requested_.store(false, std::memory_order_relaxed);
+
+        while (drainBatch() > 0) {
+        }
+
+        std::uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+        if (dropped != reported_dropped_) {
+            formatRecord(notice, Level::WARNING, "Logger queue overflow, dropped " +
+                         std::to_string(dropped - reported_dropped_) + " record(s)");
+            writeAll(fd_, notice.data(), notice.size());
+            reported_dropped_ = dropped;
+        }
+
+        if (stop_.load()) {
+            while (drainBatch() > 0) {
+            }
+            return;
+        }
+    }
 }
 
 void Logger::debug(const std::string& message) {
@@ -79,4 +290,3 @@ void Logger::error(const std::string& message) {
         log(Level::ERROR, message);
     }
 }
-
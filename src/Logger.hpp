@@ -1,22 +1,72 @@
 #pragma once
 
-#include <string>
-#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
 
 class Logger {
 public:
     enum class Level {DEBUG, INFO, WARNING, ERROR};
 
+    // Что делать производителю, если кольцевой буфер асинхронного режима полон
+    enum class OverflowPolicy {DROP, BLOCK};
+
+    struct AsyncOptions {
+        std::size_t capacity = 4096;                          // записей, округляется до степени двойки
+        std::chrono::milliseconds flush_interval{1000};       // как часто писатель сбрасывает пачку
+        OverflowPolicy overflow = OverflowPolicy::DROP;
+    };
+
+    // Синхронный режим: каждая строка — один write() под мьютексом.
     Logger(const std::string& filename, Level min_level = Level::INFO);
+    // Асинхронный режим: строки уходят в MPSC-кольцо без блокировок, а
+    // отдельный поток пишет их пачками через writev().
+    Logger(const std::string& filename, Level min_level, const AsyncOptions& options);
+    ~Logger();
+
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
 
     void log(Level level, const std::string& message);
     void debug(const std::string& message);
     void info(const std::string& message);
     void warning(const std::string& message);
     void error(const std::string& message);
+
+    // Сколько записей потеряно из-за переполнения (политика DROP)
+    std::uint64_t droppedRecords() const { return dropped_.load(std::memory_order_relaxed); }
+
 private:
-    std::ofstream file_;
+    struct Record {
+        std::atomic<std::size_t> sequence{0};
+        std::string text;
+    };
+
+    bool tryPush(Level level, const std::string& message);
+    void requestFlush();
+    void writerLoop();
+    std::size_t drainBatch();
+
+    int fd_ = -1;
     Level min_level_;
     std::mutex mutex_;
-};
\ No newline at end of file
+
+    // Асинхронный режим
+    bool async_ = false;
+    AsyncOptions options_;
+    std::unique_ptr<Record[]> ring_;
+    std::size_t mask_ = 0;
+    std::atomic<std::size_t> enqueue_pos_{0};
+    std::size_t dequeue_pos_ = 0;
+    std::atomic<std::uint64_t> dropped_{0};
+    std::uint64_t reported_dropped_ = 0;
+    std::atomic<bool> flush_requested_{false};
+    std::atomic<bool> stop_{false};
+    std::condition_variable wake_;
+    std::thread writer_;
+};
@@ -0,0 +1,87 @@
+#include "MemInfo.hpp"
+#include <cstring>
+
+namespace {
+constexpr std::uint32_t kFnvPrime = 16777619u;
+constexpr unsigned kTableBits = 8;
+constexpr std::size_t kTableSize = std::size_t{1} << kTableBits;
+
+constexpr std::uint32_t hashStep(std::uint32_t hash, char ch) {
+    return (hash ^ static_cast<unsigned char>(ch)) * kFnvPrime;
+}
+
+constexpr std::size_t bucketOf(std::uint32_t hash) {
+    return hash >> (32 - kTableBits);
+}
+
+// Затравка FNV, при которой у всех ключей разные ячейки, и сама таблица:
+// ячейка хранит номер поля + 1, 0 — пусто
+struct PerfectHash {
+    std::uint32_t seed = 0;
+    std::array<std::uint8_t, kTableSize> slots{};
+};
+
+constexpr PerfectHash buildPerfectHash() {
+    for (std::uint32_t seed = 2166136261u;; seed += 0x9e3779b9u) {
+        PerfectHash table;
+        table.seed = seed;
+        bool collision = false;
+        for (std::size_t field = 0; field < kMemInfoFields && !collision; ++field) {
+            std::uint32_t hash = seed;
+            for (char ch : kMemInfoKeys[field].key) {
+                hash = hashStep(hash, ch);
+            }
+            std::uint8_t& slot = table.slots[bucketOf(hash)];
+            collision = slot != 0;
+            slot = static_cast<std::uint8_t>(field + 1);
+        }
+        if (!collision) {
+            return table;
+        }
+    }
+}
+
+constexpr PerfectHash kPerfectHash = buildPerfectHash();
+static_assert(kMemInfoFields < kTableSize, "perfect hash table is too small");
+}
+
+void parseMemInfo(std::string_view text, MemInfo& info, std::string_view line_prefix) {
+    info.present = 0;
+    const char* p = text.data();
+    const char* end = p + text.size();
+    while (p < end) {
+        if (!line_prefix.empty() && static_cast<std::size_t>(end - p) >= line_prefix.size() &&
+            std::memcmp(p, line_prefix.data(), line_prefix.size()) == 0) {
+            p += line_prefix.size();
+        }
+        // Ключ хешируем тем же проходом, которым ищем ':'
+        const char* key = p;
+        std::uint32_t hash = kPerfectHash.seed;
+        while (p < end && *p != ':' && *p != '\n') {
+            hash = hashStep(hash, *p);
+            ++p;
+        }
+        if (p < end && *p == ':') {
+            std::uint8_t slot = kPerfectHash.slots[bucketOf(hash)];
+            std::string_view name(key, static_cast<std::size_t>(p - key));
+            if (slot != 0 && kMemInfoKeys[slot - 1].key == name) {
+                ++p;
+                while (p < end && *p == ' ') {
+                    ++p;
+                }
+                std::uint64_t value = 0;
+                const char* digits = p;
+                while (p < end && *p >= '0' && *p <= '9') {
+                    value = value * 10 + static_cast<std::uint64_t>(*p - '0');
+                    ++p;
+                }
+                if (p != digits) {
+                    info.values[slot - 1] = value;
+                    info.present |= std::uint64_t{1} << (slot - 1);
+                }
+            }
+        }
+        const char* newline = static_cast<const char*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+        p = newline ? newline + 1 : end;
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include "MetricSnapshot.hpp"
+
+// Ключ /proc/meminfo (без ':') и метрика, в которую он попадает
+struct MemInfoKey {
+    std::string_view key;
+    MetricId metric;
+};
+
+// Все ключи meminfo, которые мы читаем. Номер в этом списке — номер поля
+// в MemInfo::values; по нему же на этапе компиляции строится совершенная
+// хеш-таблица (MemInfo.cpp). Значения в kB, кроме HugePages_* — это
+// количество страниц.
+inline constexpr MemInfoKey kMemInfoKeys[] = {
+    {"MemTotal", MetricId::MEM_TOTAL_KB},
+    {"MemFree", MetricId::MEM_FREE_KB},
+    {"MemAvailable", MetricId::MEM_AVAILABLE_KB},
+    {"Buffers", MetricId::MEM_BUFFERS_KB},
+    {"Cached", MetricId::MEM_CACHED_KB},
+    {"SwapCached", MetricId::MEM_SWAP_CACHED_KB},
+    {"Active", MetricId::MEM_ACTIVE_KB},
+    {"Inactive", MetricId::MEM_INACTIVE_KB},
+    {"Unevictable", MetricId::MEM_UNEVICTABLE_KB},
+    {"Mlocked", MetricId::MEM_MLOCKED_KB},
+    {"SwapTotal", MetricId::SWAP_TOTAL_KB},
+    {"SwapFree", MetricId::SWAP_FREE_KB},
+    {"Dirty", MetricId::MEM_DIRTY_KB},
+    {"Writeback", MetricId::MEM_WRITEBACK_KB},
+    {"AnonPages", MetricId::MEM_ANON_PAGES_KB},
+    {"Mapped", MetricId::MEM_MAPPED_KB},
+    {"Shmem", MetricId::MEM_SHMEM_KB},
+    {"Slab", MetricId::MEM_SLAB_KB},
+    {"SReclaimable", MetricId::MEM_SRECLAIMABLE_KB},
+    {"SUnreclaim", MetricId::MEM_SUNRECLAIM_KB},
+    {"KernelStack", MetricId::MEM_KERNEL_STACK_KB},
+    {"PageTables", MetricId::MEM_PAGE_TABLES_KB},
+    {"CommitLimit", MetricId::MEM_COMMIT_LIMIT_KB},
+    {"Committed_AS", MetricId::MEM_COMMITTED_AS_KB},
+    {"AnonHugePages", MetricId::MEM_ANON_HUGE_KB},
+    {"ShmemHugePages", MetricId::MEM_SHMEM_HUGE_KB},
+    {"FileHugePages", MetricId::MEM_FILE_HUGE_KB},
+    {"HugePages_Total", MetricId::MEM_HUGEPAGES_TOTAL},
+    {"HugePages_Free", MetricId::MEM_HUGEPAGES_FREE},
+    {"HugePages_Rsvd", MetricId::MEM_HUGEPAGES_RSVD},
+    {"HugePages_Surp", MetricId::MEM_HUGEPAGES_SURP},
+    {"Hugepagesize", MetricId::MEM_HUGEPAGE_SIZE_KB},
+    {"Hugetlb", MetricId::MEM_HUGETLB_KB},
+};
+inline constexpr std::size_t kMemInfoFields = sizeof(kMemInfoKeys) / sizeof(kMemInfoKeys[0]);
+
+// Номер поля по ключу; вызывается на этапе компиляции
+constexpr std::size_t memInfoField(std::string_view key) {
+    for (std::size_t i = 0; i < kMemInfoFields; ++i) {
+        if (kMemInfoKeys[i].key == key) {
+            return i;
+        }
+    }
+    throw "unknown meminfo key";
+}
+
+struct MemInfo {
+    std::array<std::uint64_t, kMemInfoFields> values{};
+    std::uint64_t present = 0;   // бит i — поле i было в файле
+
+    bool has(std::size_t field) const { return (present >> field) & 1; }
+    std::uint64_t get(std::size_t field) const { return values[field]; }
+};
+static_assert(kMemInfoFields <= 64, "MemInfo::present holds one bit per field");
+
+// Один проход по тексту /proc/meminfo. Незнакомые ключи отсеиваются по
+// пустой ячейке хеш-таблицы, обычно без сравнения строк. line_prefix
+// снимается с начала каждой строки: в node*/meminfo это "Node 0 ".
+void parseMemInfo(std::string_view text, MemInfo& info, std::string_view line_prefix = {});
@@ -1,80 +1,113 @@
 #include "MemoryCollector.hpp"
-#include <iomanip>
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include "CpuTopology.hpp"
+#include <chrono>
+#include <limits>
+#include <stdexcept>
 
-MemoryCollector::MemoryCollector(Logger& logger):
-logger_(logger){
-    logger_.info("MemoryCollector start.");
-}
-
-void MemoryCollector::collect() {
-    std::ifstream file("/proc/meminfo");
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open \"/proc/meminfo\"");
-    }
-
-    std::string line;
+namespace {
+// Первые столбцы снимка; за ними — остальные поля kMemInfoKeys в их порядке
+enum MemoryColumn {
+    COL_TOTAL, COL_AVAILABLE, COL_FREE, COL_USED, COL_USED_PERCENT,
+    COL_SWAP_TOTAL, COL_SWAP_FREE, COL_SWAP_USED_PERCENT
+};
 
-    while (std::getline(file, line)) {
-        std::istringstream iss(line);
-        std::string key, value_str;
-        if (!(iss >> key >> value_str)) {
-            continue; // пропускаем пустые/битые строки
-        }
-
-        try {
-            uint64_t value = std::stoull(value_str);
+constexpr std::size_t kMemTotal = memInfoField("MemTotal");
+constexpr std::size_t kMemFree = memInfoField("MemFree");
+constexpr std::size_t kMemAvailable = memInfoField("MemAvailable");
+constexpr std::size_t kSwapTotal = memInfoField("SwapTotal");
+constexpr std::size_t kSwapFree = memInfoField("SwapFree");
 
-            if (key == "MemTotal:") {
-                total_kb_ = value;
-            } else if (key == "MemAvailable:") {
-                available_kb_ = value;
-            } else if (key == "MemFree:") {
-                free_kb_ = value;
-            } else if (key == "SwapTotal:") {
-                swap_total_kb_ = value;
-            } else if (key == "SwapFree:") {
-                swap_free_kb_ = value;
-            }
-        } catch (const std::exception&) {
-            // Пропускаем строки с некорректными числами
-            continue;
+MetricSnapshot makeSnapshot() {
+    MetricSnapshot snapshot(MetricSource::MEMORY, {
+        MetricId::MEM_TOTAL_KB, MetricId::MEM_AVAILABLE_KB, MetricId::MEM_FREE_KB,
+        MetricId::MEM_USED_KB, MetricId::MEM_USED_PERCENT,
+        MetricId::SWAP_TOTAL_KB, MetricId::SWAP_FREE_KB, MetricId::SWAP_USED_PERCENT});
+    for (const MemInfoKey& key : kMemInfoKeys) {
+        if (snapshot.column(key.metric) < 0) {
+            snapshot.columns.push_back(key.metric);
         }
     }
+    return snapshot;
+}
 
-    if (total_kb_ == 0) {
-        logger_.error("MemTotal not found in /proc/meminfo");
-        throw std::runtime_error("MemTotal not found in /proc/meminfo");
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+}
+
+MemoryCollector::MemoryCollector(const std::string& proc_root, Logger& logger):
+meminfo_reader_(proc_root + "/meminfo"),
+snapshots_(makeSnapshot()),
+logger_(logger){
+    MetricSnapshot columns = makeSnapshot();
+    for (const MemInfoKey& key : kMemInfoKeys) {
+        field_columns_.push_back(static_cast<std::size_t>(columns.column(key.metric)));
     }
+    logger_.info("MemoryCollector start.");
 }
 
-std::string MemoryCollector::getFormattedData() {
-    if (total_kb_ == 0) {
-        return "Memory: N/A";
+void MemoryCollector::enableNodes(const std::string& sys_root) {
+    std::vector<int> nodes = listNumaNodes(sys_root);
+    if (nodes.size() < 2) {
+        return;
+    }
+    for (int id : nodes) {
+        Node node;
+        node.name = "node" + std::to_string(id);
+        node.prefix = "Node " + std::to_string(id) + " ";
+        node.reader = std::make_unique<ProcReader>(sys_root + "/devices/system/node/" + node.name + "/meminfo");
+        nodes_.push_back(std::move(node));
     }
+    logger_.info("Per-node memory enabled for " + std::to_string(nodes_.size()) + " NUMA nodes");
+}
 
-    double used_kb = total_kb_ - available_kb_;
-    double used_percent = (total_kb_ > 0)
-        ? (used_kb / total_kb_) * 100.0
-        : 0.0;
+void MemoryCollector::collect() {
+    std::string_view text = meminfo_reader_.read();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    parseMemInfo(text, info_);
 
-    // Переводим в GiB для удобства
-    double total_gb = total_kb_ / (1024.0 * 1024.0);
-    double used_gb = used_kb / (1024.0 * 1024.0);
+    if (!info_.has(kMemTotal) || info_.get(kMemTotal) == 0) {
+        logger_.error("MemTotal not found in /proc/meminfo");
+        throw std::runtime_error("MemTotal not found in /proc/meminfo");
+    }
 
-    std::ostringstream oss;
-    oss << std::fixed << std::setprecision(2);
-    oss << "Memory:\n" << "  " << used_percent << "% ("
-        << used_gb << " GiB / " << total_gb << " GiB)";
+    double total_kb = static_cast<double>(info_.get(kMemTotal));
+    double used_kb = total_kb - static_cast<double>(info_.get(kMemAvailable));
+    double swap_total_kb = static_cast<double>(info_.get(kSwapTotal));
+    double swap_used_kb = swap_total_kb - static_cast<double>(info_.get(kSwapFree));
 
-    // Опционально: swap
-    if (swap_total_kb_ > 0) {
-        double swap_used = swap_total_kb_ - swap_free_kb_;
-        double swap_percent = (swap_used / swap_total_kb_) * 100.0;
-        oss << " | Swap: " << swap_percent << "%\n";
+    MetricSnapshot& snapshot = snapshots_.beginWrite();
+    snapshot.beginRows();
+    double* row = snapshot.addRow("total");
+    // Поля, которых нет в этой версии ядра, — NaN
+    for (std::size_t field = 0; field < kMemInfoFields; ++field) {
+        row[field_columns_[field]] = info_.has(field) ? static_cast<double>(info_.get(field)) : kNaN;
     }
+    row[COL_AVAILABLE] = static_cast<double>(info_.get(kMemAvailable));
+    row[COL_SWAP_TOTAL] = swap_total_kb;
+    row[COL_SWAP_FREE] = static_cast<double>(info_.get(kSwapFree));
+    row[COL_USED] = used_kb;
+    row[COL_USED_PERCENT] = used_kb / total_kb * 100.0;
+    row[COL_SWAP_USED_PERCENT] = (swap_total_kb > 0) ? swap_used_kb / swap_total_kb * 100.0 : 0.0;
 
-    return oss.str();
+    // Узлы NUMA: MemAvailable и swap там не считаются, занятое — всё кроме
+    // MemFree, вместе с page cache
+    for (Node& node : nodes_) {
+        parseMemInfo(node.reader->read(), info_, node.prefix);
+        if (!info_.has(kMemTotal) || info_.get(kMemTotal) == 0) {
+            continue;
+        }
+        double node_total_kb = static_cast<double>(info_.get(kMemTotal));
+        double node_used_kb = node_total_kb - static_cast<double>(info_.get(kMemFree));
+        row = snapshot.addRow(node.name);
+        for (std::size_t field = 0; field < kMemInfoFields; ++field) {
+            row[field_columns_[field]] = info_.has(field) ? static_cast<double>(info_.get(field)) : kNaN;
+        }
+        row[COL_AVAILABLE] = kNaN;
+        row[COL_USED] = node_used_kb;
+        row[COL_USED_PERCENT] = node_used_kb / node_total_kb * 100.0;
+        row[COL_SWAP_TOTAL] = kNaN;
+        row[COL_SWAP_FREE] = kNaN;
+        row[COL_SWAP_USED_PERCENT] = kNaN;
+    }
+    snapshot.endRows(now);
+    snapshots_.publish();
 }
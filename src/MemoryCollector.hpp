@@ -1,20 +1,36 @@
 #pragma once
 
 #include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
 #include "Logger.hpp"
+#include "MemInfo.hpp"
+#include "ProcReader.hpp"
 #include "IMetricCollector.hpp"
 
 class MemoryCollector : public IMetricCollector {
 public:
-    explicit MemoryCollector(Logger& logger);
+    MemoryCollector(const std::string& proc_root, Logger& logger);
     void collect() override;
-    std::string getFormattedData() override;
+    SnapshotGuard snapshot() const override { return snapshots_.read(); }
+
+    // Добавляет строку на каждый узел NUMA из
+    // <sys_root>/devices/system/node/node*/meminfo, если узлов больше одного
+    void enableNodes(const std::string& sys_root);
 private:
-    std::uint64_t total_kb_ = 0;
-    std::uint64_t available_kb_ = 0;
-    std::uint64_t free_kb_ = 0;
-    std::uint64_t swap_total_kb_ = 0;
-    std::uint64_t swap_free_kb_ = 0;
+    struct Node {
+        std::string name;     // "node0"
+        std::string prefix;   // "Node 0 " перед каждым ключом
+        std::unique_ptr<ProcReader> reader;
+    };
+
+    ProcReader meminfo_reader_;
+    MemInfo info_;
+    std::vector<Node> nodes_;
+    // Столбец снимка для каждого поля MemInfo
+    std::vector<std::size_t> field_columns_;
 
+    SnapshotBuffer<MetricSnapshot> snapshots_;
     Logger& logger_;
-};
\ No newline at end of file
+};
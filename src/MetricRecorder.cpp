@@ -0,0 +1,255 @@
+#include "MetricRecorder.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+constexpr char kMagic[8] = {'S', 'Y', 'S', 'M', 'R', 'E', 'C', '\0'};
+constexpr std::uint32_t kVersion = 1;
+constexpr std::size_t kPageSize = 4096;
+
+std::uint64_t clockNs(clockid_t clock) {
+    timespec ts{};
+    clock_gettime(clock, &ts);
+    return static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+}
+
+MetricRecorder::MetricRecorder(const std::string& path, std::uint64_t size_bytes,
+                               const std::vector<std::unique_ptr<IMetricCollector>>& collectors) :
+collectors_(collectors),
+layouts_(collectors.size()) {
+    for (std::size_t i = 0; i < collectors_.size(); ++i) {
+        SnapshotGuard snapshot = collectors_[i]->snapshot();
+        // Топ процессов меняет строки каждый тик: в схеме, зафиксированной
+        // при создании файла, почти все его ячейки были бы пустыми
+        if (snapshot->source == MetricSource::PROCESS) {
+            layouts_[i].recorded = false;
+            continue;
+        }
+        for (std::size_t row = 0; row < snapshot->rows(); ++row) {
+            for (MetricId id : snapshot->columns) {
+                RecordColumn column{};
+                column.source = static_cast<std::uint8_t>(snapshot->source);
+                column.metric = static_cast<std::uint16_t>(id);
+                std::strncpy(column.instance, snapshot->instances[row].c_str(), sizeof(column.instance) - 1);
+                columns_.push_back(column);
+            }
+        }
+    }
+    values_.resize(columns_.size());
+
+    std::uint64_t record_size = sizeof(RecordHeader) + columns_.size() * sizeof(double);
+    std::uint64_t schema_offset = sizeof(RecordFileHeader);
+    std::uint64_t data_offset = (schema_offset + columns_.size() * sizeof(RecordColumn) + kPageSize - 1)
+                                / kPageSize * kPageSize;
+    if (size_bytes <= data_offset || (size_bytes - data_offset) / record_size < 2) {
+        throw std::invalid_argument("Record file size is too small for " +
+                                    std::to_string(columns_.size()) + " columns");
+    }
+    std::uint64_t capacity = (size_bytes - data_offset) / record_size;
+    map_size_ = static_cast<std::size_t>(data_offset + capacity * record_size);
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open record file " + path);
+    }
+    if (ftruncate(fd_, static_cast<off_t>(map_size_)) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Cannot resize record file " + path);
+    }
+    void* map = mmap(nullptr, map_size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        ::close(fd_);
+        throw std::runtime_error("Cannot map record file " + path);
+    }
+    map_ = static_cast<unsigned char*>(map);
+
+    header_ = reinterpret_cast<RecordFileHeader*>(map_);
+    std::memcpy(header_->magic, kMagic, sizeof(kMagic));
+    header_->version = kVersion;
+    header_->column_count = static_cast<std::uint32_t>(columns_.size());
+    header_->record_size = record_size;
+    header_->capacity = capacity;
+    header_->schema_offset = schema_offset;
+    header_->data_offset = data_offset;
+    header_->records_written = 0;
+    header_->start_mono_ns = clockNs(CLOCK_MONOTONIC);
+    header_->start_wall_ns = static_cast<std::int64_t>(clockNs(CLOCK_REALTIME));
+    std::memcpy(map_ + schema_offset, columns_.data(), columns_.size() * sizeof(RecordColumn));
+}
+
+MetricRecorder::~MetricRecorder() {
+    if (map_) {
+        munmap(map_, map_size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+void MetricRecorder::mapRows(std::size_t collector, const MetricSnapshot& snapshot) {
+    SourceLayout& layout = layouts_[collector];
+    // Поэлементно в уже выделенные строки: после прогрева без аллокаций
+    layout.instances.resize(snapshot.rows());
+    for (std::size_t row = 0; row < snapshot.rows(); ++row) {
+        layout.instances[row].assign(snapshot.instances[row]);
+    }
+    layout.row_offset.assign(snapshot.rows(), -1);
+
+    std::uint8_t source = static_cast<std::uint8_t>(snapshot.source);
+    std::uint16_t first_metric = static_cast<std::uint16_t>(snapshot.columns.front());
+    for (std::size_t row = 0; row < snapshot.rows(); ++row) {
+        // Строка занимает столбцы подряд, начиная с её первой метрики
+        for (std::size_t i = 0; i < columns_.size(); ++i) {
+            if (columns_[i].source == source && columns_[i].metric == first_metric &&
+                std::strncmp(columns_[i].instance, snapshot.instances[row].c_str(),
+                             sizeof(columns_[i].instance) - 1) == 0) {
+                layout.row_offset[row] = static_cast<long>(i);
+                break;
+            }
+        }
+    }
+}
+
+void MetricRecorder::record(std::uint64_t timestamp_ns) {
+    std::fill(values_.begin(), values_.end(), std::numeric_limits<double>::quiet_NaN());
+    for (std::size_t i = 0; i < collectors_.size(); ++i) {
+        if (!layouts_[i].recorded) {
+            continue;
+        }
+        SnapshotGuard snapshot = collectors_[i]->snapshot();
+        // Карту строк пересчитываем, только если набор строк изменился
+        if (layouts_[i].instances != snapshot->instances) {
+            mapRows(i, *snapshot);
+        }
+        std::size_t width = snapshot->columns.size();
+        for (std::size_t row = 0; row < snapshot->rows(); ++row) {
+            long offset = layouts_[i].row_offset[row];
+            if (offset >= 0) {
+                std::memcpy(&values_[static_cast<std::size_t>(offset)],
+                            &snapshot->values[row * width], width * sizeof(double));
+            }
+        }
+    }
+
+    std::uint64_t k = header_->records_written;
+    unsigned char* slot = map_ + header_->data_offset + (k % header_->capacity) * header_->record_size;
+    RecordHeader* record = reinterpret_cast<RecordHeader*>(slot);
+
+    // Сначала помечаем слот битым, потом пишем данные, потом — номер.
+    // Если процесс упадёт посередине, читатель просто пропустит этот слот.
+    __atomic_store_n(&record->sequence, 0, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    record->timestamp_ns = timestamp_ns;
+    std::memcpy(slot + sizeof(RecordHeader), values_.data(), values_.size() * sizeof(double));
+    __atomic_store_n(&record->sequence, k + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&header_->records_written, k + 1, __ATOMIC_RELEASE);
+}
+
+RecordFileReader::RecordFileReader(const std::string& path) {
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open record file " + path);
+    }
+    struct stat st{};
+    if (fstat(fd_, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(RecordFileHeader)) {
+        ::close(fd_);
+        throw std::runtime_error("Not a sysmon record file: " + path);
+    }
+    map_size_ = static_cast<std::size_t>(st.st_size);
+    void* map = mmap(nullptr, map_size_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        ::close(fd_);
+        throw std::runtime_error("Cannot map record file " + path);
+    }
+    map_ = static_cast<const unsigned char*>(map);
+    header_ = reinterpret_cast<const RecordFileHeader*>(map_);
+
+    bool valid = std::memcmp(header_->magic, kMagic, sizeof(kMagic)) == 0 &&
+                 header_->version == kVersion &&
+                 header_->record_size == sizeof(RecordHeader) + header_->column_count * sizeof(double) &&
+                 header_->schema_offset + header_->column_count * sizeof(RecordColumn) <= header_->data_offset &&
+                 header_->data_offset + header_->capacity * header_->record_size <= map_size_;
+    if (!valid) {
+        munmap(const_cast<unsigned char*>(map_), map_size_);
+        ::close(fd_);
+        throw std::runtime_error("Not a sysmon record file: " + path);
+    }
+    columns_ = reinterpret_cast<const RecordColumn*>(map_ + header_->schema_offset);
+}
+
+RecordFileReader::~RecordFileReader() {
+    munmap(const_cast<unsigned char*>(map_), map_size_);
+    ::close(fd_);
+}
+
+std::uint64_t RecordFileReader::endRecord() const {
+    return __atomic_load_n(&header_->records_written, __ATOMIC_ACQUIRE);
+}
+
+std::uint64_t RecordFileReader::firstRecord() const {
+    std::uint64_t end = endRecord();
+    return (end > header_->capacity) ? end - header_->capacity : 0;
+}
+
+const double* RecordFileReader::values(std::uint64_t k, std::uint64_t& timestamp_ns) const {
+    const unsigned char* slot = map_ + header_->data_offset + (k % header_->capacity) * header_->record_size;
+    const RecordHeader* record = reinterpret_cast<const RecordHeader*>(slot);
+    if (__atomic_load_n(&record->sequence, __ATOMIC_ACQUIRE) != k + 1) {
+        return nullptr;
+    }
+    timestamp_ns = record->timestamp_ns;
+    return reinterpret_cast<const double*>(slot + sizeof(RecordHeader));
+}
+
+void RecordFileReader::buildSnapshots(const double* values, std::uint64_t timestamp_ns,
+                                      std::vector<MetricSnapshot>& snapshots) const {
+    std::size_t count = 0;
+    std::size_t i = 0;
+    std::size_t total = header_->column_count;
+    while (i < total) {
+        // Столбцы одного источника идут подряд, по строкам одинаковой ширины
+        std::uint8_t source = columns_[i].source;
+        std::size_t width = 1;
+        while (i + width < total && columns_[i + width].source == source &&
+               std::strncmp(columns_[i + width].instance, columns_[i].instance,
+                            sizeof(columns_[i].instance)) == 0) {
+            ++width;
+        }
+
+        if (count == snapshots.size()) {
+            snapshots.emplace_back();
+        }
+        MetricSnapshot& snapshot = snapshots[count++];
+        snapshot.source = static_cast<MetricSource>(source);
+        snapshot.columns.clear();
+        for (std::size_t c = 0; c < width; ++c) {
+            snapshot.columns.push_back(static_cast<MetricId>(columns_[i + c].metric));
+        }
+
+        snapshot.beginRows();
+        while (i < total && columns_[i].source == source) {
+            // Пустая строка — экземпляра не было в этом тике (устройство пропало)
+            bool present = false;
+            for (std::size_t c = 0; c < width; ++c) {
+                present = present || !std::isnan(values[i + c]);
+            }
+            if (present) {
+                double* row = snapshot.addRow(columns_[i].instance);
+                std::memcpy(row, &values[i], width * sizeof(double));
+            }
+            i += width;
+        }
+        snapshot.endRows(std::chrono::steady_clock::time_point(std::chrono::nanoseconds(timestamp_ns)));
+    }
+    snapshots.resize(count);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "IMetricCollector.hpp"
+#include "MetricSnapshot.hpp"
+
+// Формат файла записи (--record). Все поля — в порядке байт хоста.
+//
+//   [RecordFileHeader][RecordColumn x column_count] ... [данные с data_offset]
+//
+// Данные — кольцо из capacity записей фиксированной ширины record_size:
+// RecordHeader и затем column_count значений double. Запись с номером k
+// (с нуля) лежит в слоте k % capacity и считается целой, только если её
+// sequence == k + 1: перед перезаписью слота sequence обнуляется.
+struct RecordFileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t column_count;
+    std::uint64_t record_size;
+    std::uint64_t capacity;
+    std::uint64_t schema_offset;
+    std::uint64_t data_offset;
+    std::uint64_t records_written;  // сколько записей сделано за всё время
+    std::uint64_t start_mono_ns;    // CLOCK_MONOTONIC и CLOCK_REALTIME в момент
+    std::int64_t start_wall_ns;     // создания — чтобы перевести время записей в часы
+};
+
+struct RecordColumn {
+    std::uint8_t source;            // MetricSource
+    std::uint8_t reserved0;
+    std::uint16_t metric;           // MetricId
+    std::uint32_t reserved1;
+    char instance[56];              // имя строки снимка, обрезается до 55 символов
+};
+
+struct RecordHeader {
+    std::uint64_t sequence;
+    std::uint64_t timestamp_ns;     // CLOCK_MONOTONIC
+};
+
+// Пишет каждый тик в кольцевой файл, отображённый в память. Запись — это
+// memcpy в отображение без системных вызовов; данные переживают падение
+// процесса, потому что страницы принадлежат файлу, а не процессу.
+class MetricRecorder {
+public:
+    // Схема (столбцы) фиксируется по текущим снимкам collectors; строки,
+    // появившиеся позже, не записываются. Процессы не записываются вовсе.
+    MetricRecorder(const std::string& path, std::uint64_t size_bytes,
+                   const std::vector<std::unique_ptr<IMetricCollector>>& collectors);
+    ~MetricRecorder();
+
+    MetricRecorder(const MetricRecorder&) = delete;
+    MetricRecorder& operator=(const MetricRecorder&) = delete;
+
+    // Добавить запись с текущими значениями всех коллекторов
+    void record(std::uint64_t timestamp_ns);
+
+    std::size_t columnCount() const { return columns_.size(); }
+    std::uint64_t capacity() const { return header_->capacity; }
+
+private:
+    // Куда в записи класть строки снимка одного коллектора
+    struct SourceLayout {
+        std::vector<std::string> instances;  // для каких строк посчитана карта
+        std::vector<long> row_offset;        // строка -> первый столбец или -1
+        bool recorded = true;                // есть ли у коллектора столбцы в схеме
+    };
+
+    void mapRows(std::size_t collector, const MetricSnapshot& snapshot);
+
+    const std::vector<std::unique_ptr<IMetricCollector>>& collectors_;
+    std::vector<RecordColumn> columns_;
+    std::vector<SourceLayout> layouts_;
+    std::vector<double> values_;
+
+    int fd_ = -1;
+    std::size_t map_size_ = 0;
+    unsigned char* map_ = nullptr;
+    RecordFileHeader* header_ = nullptr;
+};
+
+// Чтение файла записи для dump и replay
+class RecordFileReader {
+public:
+    explicit RecordFileReader(const std::string& path);
+    ~RecordFileReader();
+
+    RecordFileReader(const RecordFileReader&) = delete;
+    RecordFileReader& operator=(const RecordFileReader&) = delete;
+
+    const RecordFileHeader& header() const { return *header_; }
+    const RecordColumn* columns() const { return columns_; }
+
+    // Номера сохранившихся записей: [firstRecord(), endRecord())
+    std::uint64_t firstRecord() const;
+    std::uint64_t endRecord() const;
+    // Указатель на значения записи k или nullptr, если запись перезаписана/не дописана
+    const double* values(std::uint64_t k, std::uint64_t& timestamp_ns) const;
+
+    // Собирает снимки по источникам из значений одной записи
+    void buildSnapshots(const double* values, std::uint64_t timestamp_ns,
+                        std::vector<MetricSnapshot>& snapshots) const;
+
+private:
+    int fd_ = -1;
+    std::size_t map_size_ = 0;
+    const unsigned char* map_ = nullptr;
+    const RecordFileHeader* header_ = nullptr;
+    const RecordColumn* columns_ = nullptr;
+};
@@ -0,0 +1,126 @@
+#include "MetricSnapshot.hpp"
+
+const char* sourceName(MetricSource source) {
+    switch (source) {
+    case MetricSource::CPU:
+        return "cpu";
+    case MetricSource::MEMORY:
+        return "memory";
+    case MetricSource::DISK:
+        return "disk";
+    case MetricSource::NET:
+        return "net";
+    case MetricSource::PROCESS:
+        return "process";
+    case MetricSource::CGROUP:
+        return "cgroup";
+    case MetricSource::PRESSURE:
+        return "pressure";
+    case MetricSource::SELF:
+        return "self";
+    }
+    return "unknown";
+}
+
+const char* metricName(MetricId id) {
+    switch (id) {
+    case MetricId::CPU_USAGE_PERCENT:   return "cpu.usage_percent";
+    case MetricId::CPU_CORES:           return "cpu.cores";
+    case MetricId::CPU_USER_PERCENT:    return "cpu.user_percent";
+    case MetricId::CPU_NICE_PERCENT:    return "cpu.nice_percent";
+    case MetricId::CPU_SYSTEM_PERCENT:  return "cpu.system_percent";
+    case MetricId::CPU_IDLE_PERCENT:    return "cpu.idle_percent";
+    case MetricId::CPU_IOWAIT_PERCENT:  return "cpu.iowait_percent";
+    case MetricId::CPU_IRQ_PERCENT:     return "cpu.irq_percent";
+    case MetricId::CPU_SOFTIRQ_PERCENT: return "cpu.softirq_percent";
+    case MetricId::CPU_STEAL_PERCENT:   return "cpu.steal_percent";
+    case MetricId::CPU_GUEST_PERCENT:   return "cpu.guest_percent";
+    case MetricId::MEM_TOTAL_KB:        return "mem.total_kb";
+    case MetricId::MEM_AVAILABLE_KB:    return "mem.available_kb";
+    case MetricId::MEM_FREE_KB:         return "mem.free_kb";
+    case MetricId::MEM_USED_KB:         return "mem.used_kb";
+    case MetricId::MEM_USED_PERCENT:    return "mem.used_percent";
+    case MetricId::SWAP_TOTAL_KB:       return "swap.total_kb";
+    case MetricId::SWAP_FREE_KB:        return "swap.free_kb";
+    case MetricId::SWAP_USED_PERCENT:   return "swap.used_percent";
+    case MetricId::MEM_BUFFERS_KB:      return "mem.buffers_kb";
+    case MetricId::MEM_CACHED_KB:       return "mem.cached_kb";
+    case MetricId::MEM_SWAP_CACHED_KB:  return "mem.swap_cached_kb";
+    case MetricId::MEM_ACTIVE_KB:       return "mem.active_kb";
+    case MetricId::MEM_INACTIVE_KB:     return "mem.inactive_kb";
+    case MetricId::MEM_UNEVICTABLE_KB:  return "mem.unevictable_kb";
+    case MetricId::MEM_MLOCKED_KB:      return "mem.mlocked_kb";
+    case MetricId::MEM_DIRTY_KB:        return "mem.dirty_kb";
+    case MetricId::MEM_WRITEBACK_KB:    return "mem.writeback_kb";
+    case MetricId::MEM_ANON_PAGES_KB:   return "mem.anon_pages_kb";
+    case MetricId::MEM_MAPPED_KB:       return "mem.mapped_kb";
+    case MetricId::MEM_SHMEM_KB:        return "mem.shmem_kb";
+    case MetricId::MEM_SLAB_KB:         return "mem.slab_kb";
+    case MetricId::MEM_SRECLAIMABLE_KB: return "mem.sreclaimable_kb";
+    case MetricId::MEM_SUNRECLAIM_KB:   return "mem.sunreclaim_kb";
+    case MetricId::MEM_KERNEL_STACK_KB: return "mem.kernel_stack_kb";
+    case MetricId::MEM_PAGE_TABLES_KB:  return "mem.page_tables_kb";
+    case MetricId::MEM_COMMIT_LIMIT_KB: return "mem.commit_limit_kb";
+    case MetricId::MEM_COMMITTED_AS_KB: return "mem.committed_as_kb";
+    case MetricId::MEM_ANON_HUGE_KB:    return "mem.anon_huge_kb";
+    case MetricId::MEM_SHMEM_HUGE_KB:   return "mem.shmem_huge_kb";
+    case MetricId::MEM_FILE_HUGE_KB:    return "mem.file_huge_kb";
+    case MetricId::MEM_HUGEPAGES_TOTAL: return "mem.hugepages_total";
+    case MetricId::MEM_HUGEPAGES_FREE:  return "mem.hugepages_free";
+    case MetricId::MEM_HUGEPAGES_RSVD:  return "mem.hugepages_rsvd";
+    case MetricId::MEM_HUGEPAGES_SURP:  return "mem.hugepages_surp";
+    case MetricId::MEM_HUGEPAGE_SIZE_KB: return "mem.hugepage_size_kb";
+    case MetricId::MEM_HUGETLB_KB:      return "mem.hugetlb_kb";
+    case MetricId::DISK_READ_IOPS:      return "disk.read_iops";
+    case MetricId::DISK_WRITE_IOPS:     return "disk.write_iops";
+    case MetricId::DISK_READ_MIB_S:     return "disk.read_mib_s";
+    case MetricId::DISK_WRITE_MIB_S:    return "disk.write_mib_s";
+    case MetricId::DISK_UTIL_PERCENT:   return "disk.util_percent";
+    case MetricId::DISK_READ_AWAIT_MS:  return "disk.read_await_ms";
+    case MetricId::DISK_WRITE_AWAIT_MS: return "disk.write_await_ms";
+    case MetricId::DISK_QUEUE_DEPTH:    return "disk.queue_depth";
+    case MetricId::DISK_REQUEST_KB:     return "disk.request_kb";
+    case MetricId::DISK_READ_MERGED_S:  return "disk.read_merged_s";
+    case MetricId::DISK_WRITE_MERGED_S: return "disk.write_merged_s";
+    case MetricId::NET_RX_MIB_S:        return "net.rx_mib_s";
+    case MetricId::NET_TX_MIB_S:        return "net.tx_mib_s";
+    case MetricId::NET_RX_PACKETS_S:    return "net.rx_packets_s";
+    case MetricId::NET_TX_PACKETS_S:    return "net.tx_packets_s";
+    case MetricId::NET_RX_ERRORS_S:     return "net.rx_errors_s";
+    case MetricId::NET_TX_ERRORS_S:     return "net.tx_errors_s";
+    case MetricId::NET_RX_DROPS_S:      return "net.rx_drops_s";
+    case MetricId::NET_TX_DROPS_S:      return "net.tx_drops_s";
+    case MetricId::NET_RX_FIFO_S:       return "net.rx_fifo_s";
+    case MetricId::NET_TX_FIFO_S:       return "net.tx_fifo_s";
+    case MetricId::NET_RX_MULTICAST_S:  return "net.rx_multicast_s";
+    case MetricId::NET_RX_PACKET_BYTES: return "net.rx_packet_bytes";
+    case MetricId::NET_TX_PACKET_BYTES: return "net.tx_packet_bytes";
+    case MetricId::PROC_PID:            return "proc.pid";
+    case MetricId::PROC_CPU_PERCENT:    return "proc.cpu_percent";
+    case MetricId::PROC_RSS_KB:         return "proc.rss_kb";
+    case MetricId::PROC_READ_MIB_S:     return "proc.read_mib_s";
+    case MetricId::PROC_WRITE_MIB_S:    return "proc.write_mib_s";
+    case MetricId::CG_CPU_PERCENT:      return "cgroup.cpu_percent";
+    case MetricId::CG_MEMORY_KB:        return "cgroup.memory_kb";
+    case MetricId::CG_ANON_KB:          return "cgroup.anon_kb";
+    case MetricId::CG_FILE_KB:          return "cgroup.file_kb";
+    case MetricId::CG_READ_MIB_S:       return "cgroup.read_mib_s";
+    case MetricId::CG_WRITE_MIB_S:      return "cgroup.write_mib_s";
+    case MetricId::PSI_SOME_AVG10:      return "psi.some_avg10";
+    case MetricId::PSI_SOME_AVG60:      return "psi.some_avg60";
+    case MetricId::PSI_SOME_PERCENT:    return "psi.some_percent";
+    case MetricId::PSI_FULL_AVG10:      return "psi.full_avg10";
+    case MetricId::PSI_FULL_AVG60:      return "psi.full_avg60";
+    case MetricId::PSI_FULL_PERCENT:    return "psi.full_percent";
+    case MetricId::SELF_CPU_PERCENT:    return "self.cpu_percent";
+    case MetricId::SELF_RSS_KB:         return "self.rss_kb";
+    case MetricId::SELF_MISSED_TICKS:   return "self.missed_ticks";
+    case MetricId::SELF_SKIPPED:        return "self.skipped";
+    case MetricId::SELF_CALLS:          return "self.calls";
+    case MetricId::SELF_MEAN_US:        return "self.mean_us";
+    case MetricId::SELF_P50_US:         return "self.p50_us";
+    case MetricId::SELF_P99_US:         return "self.p99_us";
+    case MetricId::SELF_MAX_US:         return "self.max_us";
+    }
+    return "unknown";
+}
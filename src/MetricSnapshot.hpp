@@ -0,0 +1,187 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Какой коллектор опубликовал снимок
+enum class MetricSource : std::uint8_t {
+    CPU,
+    MEMORY,
+    DISK,
+    NET,
+    PROCESS,
+    CGROUP,
+    PRESSURE,
+    SELF,
+};
+
+// Стабильные идентификаторы метрик. Номера не переиспользуются:
+// новые метрики добавляются в свою сотню, старые не перенумеровываются.
+enum class MetricId : std::uint16_t {
+    CPU_USAGE_PERCENT = 0,
+    CPU_CORES = 1,
+    CPU_USER_PERCENT = 2,
+    CPU_NICE_PERCENT = 3,
+    CPU_SYSTEM_PERCENT = 4,
+    CPU_IDLE_PERCENT = 5,
+    CPU_IOWAIT_PERCENT = 6,
+    CPU_IRQ_PERCENT = 7,
+    CPU_SOFTIRQ_PERCENT = 8,
+    CPU_STEAL_PERCENT = 9,
+    CPU_GUEST_PERCENT = 10,
+
+    MEM_TOTAL_KB = 100,
+    MEM_AVAILABLE_KB = 101,
+    MEM_FREE_KB = 102,
+    MEM_USED_KB = 103,
+    MEM_USED_PERCENT = 104,
+    SWAP_TOTAL_KB = 105,
+    SWAP_FREE_KB = 106,
+    SWAP_USED_PERCENT = 107,
+    MEM_BUFFERS_KB = 108,
+    MEM_CACHED_KB = 109,
+    MEM_SWAP_CACHED_KB = 110,
+    MEM_ACTIVE_KB = 111,
+    MEM_INACTIVE_KB = 112,
+    MEM_UNEVICTABLE_KB = 113,
+    MEM_MLOCKED_KB = 114,
+    MEM_DIRTY_KB = 115,
+    MEM_WRITEBACK_KB = 116,
+    MEM_ANON_PAGES_KB = 117,
+    MEM_MAPPED_KB = 118,
+    MEM_SHMEM_KB = 119,
+    MEM_SLAB_KB = 120,
+    MEM_SRECLAIMABLE_KB = 121,
+    MEM_SUNRECLAIM_KB = 122,
+    MEM_KERNEL_STACK_KB = 123,
+    MEM_PAGE_TABLES_KB = 124,
+    MEM_COMMIT_LIMIT_KB = 125,
+    MEM_COMMITTED_AS_KB = 126,
+    MEM_ANON_HUGE_KB = 127,
+    MEM_SHMEM_HUGE_KB = 128,
+    MEM_FILE_HUGE_KB = 129,
+    MEM_HUGEPAGES_TOTAL = 130,
+    MEM_HUGEPAGES_FREE = 131,
+    MEM_HUGEPAGES_RSVD = 132,
+    MEM_HUGEPAGES_SURP = 133,
+    MEM_HUGEPAGE_SIZE_KB = 134,
+    MEM_HUGETLB_KB = 135,
+
+    DISK_READ_IOPS = 200,
+    DISK_WRITE_IOPS = 201,
+    DISK_READ_MIB_S = 202,
+    DISK_WRITE_MIB_S = 203,
+    DISK_UTIL_PERCENT = 204,
+    DISK_READ_AWAIT_MS = 205,
+    DISK_WRITE_AWAIT_MS = 206,
+    DISK_QUEUE_DEPTH = 207,
+    DISK_REQUEST_KB = 208,
+    DISK_READ_MERGED_S = 209,
+    DISK_WRITE_MERGED_S = 210,
+
+    NET_RX_MIB_S = 300,
+    NET_TX_MIB_S = 301,
+    NET_RX_PACKETS_S = 302,
+    NET_TX_PACKETS_S = 303,
+    NET_RX_ERRORS_S = 304,
+    NET_TX_ERRORS_S = 305,
+    NET_RX_DROPS_S = 306,
+    NET_TX_DROPS_S = 307,
+    NET_RX_FIFO_S = 308,
+    NET_TX_FIFO_S = 309,
+    NET_RX_MULTICAST_S = 310,
+    NET_RX_PACKET_BYTES = 311,
+    NET_TX_PACKET_BYTES = 312,
+
+    PROC_PID = 400,
+    PROC_CPU_PERCENT = 401,
+    PROC_RSS_KB = 402,
+    PROC_READ_MIB_S = 403,
+    PROC_WRITE_MIB_S = 404,
+
+    CG_CPU_PERCENT = 500,
+    CG_MEMORY_KB = 501,
+    CG_ANON_KB = 502,
+    CG_FILE_KB = 503,
+    CG_READ_MIB_S = 504,
+    CG_WRITE_MIB_S = 505,
+
+    PSI_SOME_AVG10 = 600,
+    PSI_SOME_AVG60 = 601,
+    PSI_SOME_PERCENT = 602,
+    PSI_FULL_AVG10 = 603,
+    PSI_FULL_AVG60 = 604,
+    PSI_FULL_PERCENT = 605,
+
+    SELF_CPU_PERCENT = 700,
+    SELF_RSS_KB = 701,
+    SELF_MISSED_TICKS = 702,
+    SELF_SKIPPED = 703,
+    SELF_CALLS = 704,
+    SELF_MEAN_US = 705,
+    SELF_P50_US = 706,
+    SELF_P99_US = 707,
+    SELF_MAX_US = 708,
+};
+
+const char* sourceName(MetricSource source);
+// Имя метрики для машинного вывода, например "disk.read_mib_s"
+const char* metricName(MetricId id);
+
+// Снимок коллектора — таблица чисел: строки — экземпляры (весь хост,
+// ядро, диск, интерфейс, процесс, cgroup), столбцы — метрики. Набор столбцов задаётся один
+// раз в конструкторе коллектора, строки перезаполняются на каждом тике
+// с переиспользованием уже выделенных буферов. Коллекторы публикуют
+// снимки через SnapshotBuffer, поэтому номер публикации хранится там.
+struct MetricSnapshot {
+    MetricSnapshot() = default;
+    MetricSnapshot(MetricSource source_, std::vector<MetricId> columns_) :
+    source(source_), columns(std::move(columns_)) {
+    }
+
+    MetricSource source = MetricSource::CPU;
+    std::vector<MetricId> columns;
+    std::uint64_t timestamp_ns = 0; // CLOCK_MONOTONIC на момент чтения счётчиков
+    std::vector<std::string> instances;
+    std::vector<double> values;     // instances.size() * columns.size(), по строкам
+
+    std::size_t rows() const { return instances.size(); }
+    double value(std::size_t row, std::size_t column) const {
+        return values[row * columns.size() + column];
+    }
+    // Индекс столбца или -1, если такой метрики в снимке нет
+    int column(MetricId id) const {
+        for (std::size_t i = 0; i < columns.size(); ++i) {
+            if (columns[i] == id) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    void beginRows() {
+        row_count_ = 0;
+    }
+    // Добавляет строку и возвращает указатель на её columns.size() ячеек
+    double* addRow(std::string_view instance) {
+        if (row_count_ == instances.size()) {
+            instances.emplace_back();
+        }
+        instances[row_count_].assign(instance.data(), instance.size());
+        values.resize((row_count_ + 1) * columns.size());
+        return &values[row_count_++ * columns.size()];
+    }
+    // Завершает заполнение: отрезает лишние строки и ставит время
+    void endRows(std::chrono::steady_clock::time_point when) {
+        instances.resize(row_count_);
+        values.resize(row_count_ * columns.size());
+        timestamp_ns = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(when.time_since_epoch()).count());
+    }
+
+private:
+    std::size_t row_count_ = 0;
+};
@@ -0,0 +1,108 @@
+#include "NameTable.hpp"
+
+namespace {
+constexpr std::size_t kMinBuckets = 16;
+}
+
+NameTable::NameTable() :
+buckets_(kMinBuckets) {
+}
+
+std::uint64_t NameTable::hashName(std::string_view name) {
+    // FNV-1a: имена короткие, этого достаточно
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char ch : name) {
+        hash ^= static_cast<unsigned char>(ch);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::size_t NameTable::findBucket(std::string_view name, std::uint64_t hash) const {
+    std::size_t mask = buckets_.size() - 1;
+    for (std::size_t i = hash & mask;; i = (i + 1) & mask) {
+        const Bucket& bucket = buckets_[i];
+        if (bucket.slot == kEmpty) {
+            return kNoBucket;
+        }
+        if (bucket.slot != kDeleted && bucket.hash == static_cast<std::uint32_t>(hash) &&
+            names_[bucket.slot] == name) {
+            return i;
+        }
+    }
+}
+
+std::uint32_t NameTable::find(std::string_view name) const {
+    std::size_t i = findBucket(name, hashName(name));
+    return (i == kNoBucket) ? kNoSlot : buckets_[i].slot;
+}
+
+std::uint32_t NameTable::intern(std::string_view name) {
+    std::uint64_t hash = hashName(name);
+    std::size_t found = findBucket(name, hash);
+    if (found != kNoBucket) {
+        return buckets_[found].slot;
+    }
+
+    // Заполненность (с удалёнными) держим не выше половины
+    if ((used_ + 1) * 2 > buckets_.size()) {
+        std::size_t count = kMinBuckets;
+        while (count < (live_ + 1) * 4) {
+            count *= 2;
+        }
+        rehash(count);
+    }
+
+    std::uint32_t slot;
+    if (!free_slots_.empty()) {
+        slot = free_slots_.back();
+        free_slots_.pop_back();
+        names_[slot].assign(name.data(), name.size());
+    } else {
+        slot = static_cast<std::uint32_t>(names_.size());
+        names_.emplace_back(name);
+    }
+
+    std::size_t mask = buckets_.size() - 1;
+    std::size_t i = hash & mask;
+    while (buckets_[i].slot != kEmpty && buckets_[i].slot != kDeleted) {
+        i = (i + 1) & mask;
+    }
+    if (buckets_[i].slot == kEmpty) {
+        ++used_;
+    }
+    buckets_[i].slot = slot;
+    buckets_[i].hash = static_cast<std::uint32_t>(hash);
+    ++live_;
+    return slot;
+}
+
+void NameTable::release(std::uint32_t slot) {
+    std::size_t i = findBucket(names_[slot], hashName(names_[slot]));
+    if (i == kNoBucket || buckets_[i].slot != slot) {
+        return;
+    }
+    buckets_[i].slot = kDeleted;
+    names_[slot].clear(); // ёмкость строки остаётся для следующего имени
+    free_slots_.push_back(slot);
+    --live_;
+}
+
+void NameTable::rehash(std::size_t bucket_count) {
+    std::vector<Bucket> old;
+    old.swap(buckets_);
+    buckets_.assign(bucket_count, Bucket{});
+    used_ = 0;
+    std::size_t mask = bucket_count - 1;
+    for (const Bucket& bucket : old) {
+        if (bucket.slot == kEmpty || bucket.slot == kDeleted) {
+            continue;
+        }
+        std::size_t i = hashName(names_[bucket.slot]) & mask;
+        while (buckets_[i].slot != kEmpty) {
+            i = (i + 1) & mask;
+        }
+        buckets_[i] = bucket;
+        ++used_;
+    }
+}
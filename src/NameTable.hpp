@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Интернирует имена устройств: имя -> номер слота. Номер не меняется, пока
+// имя не освобождено через release(), поэтому счётчики устройства можно
+// хранить в плоских массивах по номеру слота. Освобождённые номера
+// переиспользуются, так что массивы не растут от пересоздания veth и dm.
+//
+// Внутри — открытая адресация с линейным пробированием; поиск идёт по
+// string_view и не выделяет память.
+class NameTable {
+public:
+    static constexpr std::uint32_t kNoSlot = UINT32_MAX;
+
+    NameTable();
+
+    // Номер слота для имени; новое имя получает свободный номер
+    std::uint32_t intern(std::string_view name);
+    // Номер слота или kNoSlot
+    std::uint32_t find(std::string_view name) const;
+    // Освободить слот; номер может достаться другому имени
+    void release(std::uint32_t slot);
+
+    std::string_view name(std::uint32_t slot) const { return names_[slot]; }
+    // Все номера меньше slotCount() — по нему выделяются массивы по слотам
+    std::size_t slotCount() const { return names_.size(); }
+    std::size_t size() const { return live_; }
+
+private:
+    static constexpr std::size_t kNoBucket = SIZE_MAX;
+    static constexpr std::uint32_t kEmpty = UINT32_MAX;
+    static constexpr std::uint32_t kDeleted = UINT32_MAX - 1;
+
+    struct Bucket {
+        std::uint32_t slot = kEmpty;
+        std::uint32_t hash = 0;  // младшие биты хеша — чтобы реже сравнивать строки
+    };
+
+    static std::uint64_t hashName(std::string_view name);
+    // Корзина с этим именем или kNoBucket
+    std::size_t findBucket(std::string_view name, std::uint64_t hash) const;
+    void rehash(std::size_t bucket_count);
+
+    std::vector<Bucket> buckets_;
+    std::vector<std::string> names_;
+    std::vector<std::uint32_t> free_slots_;
+    std::size_t live_ = 0;
+    std::size_t used_ = 0;  // живые + удалённые корзины
+};
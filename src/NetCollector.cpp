@@ -1,125 +1,187 @@
 #include "NetCollector.hpp"
-#include <algorithm>
-#include <istream>
-#include <fstream>
-#include <iomanip>
-#include <iostream>
-
-NetCollector::NetCollector(std::chrono::milliseconds interval, Logger& logger) :
-interval_(interval), 
-first_run_(true), 
+#include <stdexcept>
+#include <utility>
+#include "NetlinkLinkReader.hpp"
+
+namespace {
+// Порядок столбцов снимка
+enum NetColumn { COL_RX_MIB_S, COL_TX_MIB_S, COL_RX_PACKETS, COL_TX_PACKETS,
+                 COL_RX_ERRORS, COL_TX_ERRORS, COL_RX_DROPS, COL_TX_DROPS,
+                 COL_RX_FIFO, COL_TX_FIFO, COL_RX_MULTICAST, COL_RX_PACKET_BYTES, COL_TX_PACKET_BYTES };
+
+std::uint64_t counterDiff(std::uint64_t current, std::uint64_t previous) {
+    return (current > previous) ? current - previous : 0;
+}
+}
+
+NetCollector::NetCollector(const std::string& proc_root, NetBackend backend, DeviceFilter filter, Logger& logger) :
+first_run_(true),
+netdev_reader_(proc_root + "/net/dev"),
+filter_(std::move(filter)),
+snapshots_(MetricSnapshot(MetricSource::NET, {
+    MetricId::NET_RX_MIB_S, MetricId::NET_TX_MIB_S, MetricId::NET_RX_PACKETS_S, MetricId::NET_TX_PACKETS_S,
+    MetricId::NET_RX_ERRORS_S, MetricId::NET_TX_ERRORS_S, MetricId::NET_RX_DROPS_S, MetricId::NET_TX_DROPS_S,
+    MetricId::NET_RX_FIFO_S, MetricId::NET_TX_FIFO_S, MetricId::NET_RX_MULTICAST_S,
+    MetricId::NET_RX_PACKET_BYTES, MetricId::NET_TX_PACKET_BYTES})),
 logger_(logger){
-    logger_.info("NetCollector start.");
+    if (backend == NetBackend::NETLINK) {
+        netlink_ = std::make_unique<NetlinkLinkReader>();
+    } else if (backend == NetBackend::AUTO && proc_root == "/proc") {
+        try {
+            netlink_ = std::make_unique<NetlinkLinkReader>();
+        } catch (const std::exception& e) {
+            logger_.warning(std::string(e.what()) + ", falling back to " + netdev_reader_.path());
+        }
+    }
+    logger_.info("NetCollector start. Source: " + (netlink_ ? std::string("rtnetlink") : netdev_reader_.path()));
 }
 
-std::vector<NetInterface> readNetDev() {
-    std::ifstream file("/proc/net/dev");
-    if (!file.is_open()) {
-        throw std::runtime_error("Cannot open /proc/net/dev");
+NetCollector::~NetCollector() = default;
+
+bool NetCollector::showSlot(std::uint32_t slot) {
+    SlotState& state = slot_state_[slot];
+    if (state == SLOT_UNKNOWN) {
+        state = filter_.accepts(names_.name(slot)) ? SLOT_SHOWN : SLOT_HIDDEN;
     }
+    return state == SLOT_SHOWN;
+}
 
-    std::vector<NetInterface> interfaces;
-    std::string line;
+void readNetDev(std::string_view text, NameTable& names, std::vector<NetInterface>& interfaces) {
+    std::size_t count = 0;
+    std::string_view line;
 
-    std::getline(file, line); // "Inter-|   Receive..."
-    std::getline(file, line); // " face |bytes    packets..."
+    nextLine(text, line); // "Inter-|   Receive..."
+    nextLine(text, line); // " face |bytes    packets..."
 
-    while (std::getline(file, line)) {
+    while (nextLine(text, line)) {
         size_t pos = line.find(':');
-        if (pos == std::string::npos) {
+        if (pos == std::string_view::npos) {
             continue;
         }
-        std::string name = line.substr(0, pos);
+        std::string_view name = line.substr(0, pos);
         // Убираем начальные пробелы
-        name.erase(name.begin(), std::find_if(name.begin(), name.end(), [](unsigned char ch) {
-            return !std::isspace(ch);
-        }));
-
-        std::istringstream iss(line.substr(pos + 1));
-        std::vector<uint64_t> stats;
-        uint64_t val;
-        while (stats.size() < 16 && iss >> val) {
-            stats.push_back(val);
+        skipSpaces(name);
+        line.remove_prefix(pos + 1);
+
+        std::uint64_t stats[16];
+        bool valid = true;
+        for (std::uint64_t& value : stats) {
+            if (!parseUint(line, value)) {
+                valid = false;
+                break;
+            }
         }
 
-        if (stats.size() < 16) {
+        if (!valid) {
             continue;
         }
 
-        NetInterface iface;
-        iface.name = name;
-        iface.rx_bytes = stats[0];  // received bytes
-        iface.tx_bytes = stats[8];  // transmitted bytes
-
-        interfaces.push_back(iface);
+        if (count == interfaces.size()) {
+            interfaces.emplace_back();
+        }
+        NetInterface& iface = interfaces[count++];
+        iface.slot = names.intern(name);
+        // bytes packets errs drop fifo frame compressed multicast — приём, затем
+        // bytes packets errs drop fifo colls carrier compressed — передача
+        iface.rx_bytes = stats[0];
+        iface.rx_packets = stats[1];
+        iface.rx_errors = stats[2];
+        iface.rx_dropped = stats[3];
+        iface.rx_fifo = stats[4];
+        iface.rx_multicast = stats[7];
+        iface.tx_bytes = stats[8];
+        iface.tx_packets = stats[9];
+        iface.tx_errors = stats[10];
+        iface.tx_dropped = stats[11];
+        iface.tx_fifo = stats[12];
     }
+    interfaces.resize(count);
 
     if (interfaces.empty()) {
         throw std::runtime_error("No network interfaces found in /proc/net/dev");
     }
-
-    return interfaces;
 }
 
 void NetCollector::collect() {
     try {
-        std::vector<NetInterface> current = readNetDev();
-
-        if (first_run_) {
-            prev_stats_ = current;
-            first_run_ = false;
-            current_metrics_.clear();
-            return;
+        ++tick_;
+        if (netlink_) {
+            netlink_->read(names_, current_stats_);
+        } else {
+            readNetDev(netdev_reader_.read(), names_, current_stats_);
+        }
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (names_.slotCount() > prev_by_slot_.size()) {
+            prev_by_slot_.resize(names_.slotCount());
+            seen_tick_.resize(names_.slotCount(), 0);
+            slot_state_.resize(names_.slotCount(), SLOT_UNKNOWN);
         }
 
-        current_metrics_.clear();
-        double interval_sec = interval_.count() / 1000.0;
-
-        for (const auto& curr : current) {
-            auto it = std::find_if(prev_stats_.begin(), prev_stats_.end(),
-                [&curr](const NetInterface& i) { return i.name == curr.name; });
-
-            if (it == prev_stats_.end()) {
-                continue; // новый интерфейс
+        bool publish = !first_run_;
+        MetricSnapshot* snapshot = nullptr;
+        if (publish) {
+            snapshot = &snapshots_.beginWrite();
+            snapshot->beginRows();
+        }
+        // Скорости считаем по реально прошедшему времени, а не по заданному интервалу
+        double interval_sec = std::chrono::duration<double>(now - prev_time_).count();
+
+        for (const NetInterface& curr : current_stats_) {
+            // Новый интерфейс (не было в прошлом тике) пропускаем в этот раз
+            if (publish && seen_tick_[curr.slot] + 1 == tick_ && showSlot(curr.slot)) {
+                const NetInterface& prev = prev_by_slot_[curr.slot];
+
+                std::uint64_t rx_diff = counterDiff(curr.rx_bytes, prev.rx_bytes);
+                std::uint64_t tx_diff = counterDiff(curr.tx_bytes, prev.tx_bytes);
+                std::uint64_t rx_packets = counterDiff(curr.rx_packets, prev.rx_packets);
+                std::uint64_t tx_packets = counterDiff(curr.tx_packets, prev.tx_packets);
+                // Скорость счётчика за интервал
+                auto rate = [interval_sec](std::uint64_t diff) {
+                    return (interval_sec > 0) ? diff / interval_sec : 0.0;
+                };
+
+                double* m = snapshot->addRow(names_.name(curr.slot));
+                m[COL_RX_MIB_S] = rate(rx_diff) / (1024.0 * 1024.0);
+                m[COL_TX_MIB_S] = rate(tx_diff) / (1024.0 * 1024.0);
+                m[COL_RX_PACKETS] = rate(rx_packets);
+                m[COL_TX_PACKETS] = rate(tx_packets);
+                m[COL_RX_ERRORS] = rate(counterDiff(curr.rx_errors, prev.rx_errors));
+                m[COL_TX_ERRORS] = rate(counterDiff(curr.tx_errors, prev.tx_errors));
+                m[COL_RX_DROPS] = rate(counterDiff(curr.rx_dropped, prev.rx_dropped));
+                m[COL_TX_DROPS] = rate(counterDiff(curr.tx_dropped, prev.tx_dropped));
+                m[COL_RX_FIFO] = rate(counterDiff(curr.rx_fifo, prev.rx_fifo));
+                m[COL_TX_FIFO] = rate(counterDiff(curr.tx_fifo, prev.tx_fifo));
+                m[COL_RX_MULTICAST] = rate(counterDiff(curr.rx_multicast, prev.rx_multicast));
+                m[COL_RX_PACKET_BYTES] = (rx_packets > 0) ? static_cast<double>(rx_diff) / rx_packets : 0.0;
+                m[COL_TX_PACKET_BYTES] = (tx_packets > 0) ? static_cast<double>(tx_diff) / tx_packets : 0.0;
             }
-
-            const NetInterface& prev = *it;
-
-            std::uint64_t rx_diff = (curr.rx_bytes > prev.rx_bytes) ? (curr.rx_bytes - prev.rx_bytes) : 0;
-            std::uint64_t tx_diff = (curr.tx_bytes > prev.tx_bytes) ? (curr.tx_bytes - prev.tx_bytes) : 0;
-
-            NetMetrics m;
-            m.name = curr.name;
-            m.rx_mib_s = (interval_sec > 0) ? (rx_diff / (1024.0 * 1024.0) / interval_sec) : 0.0;
-            m.tx_mib_s = (interval_sec > 0) ? (tx_diff / (1024.0 * 1024.0) / interval_sec) : 0.0;
-
-            current_metrics_.push_back(m);
+            prev_by_slot_[curr.slot] = curr;
+            seen_tick_[curr.slot] = tick_;
+        }
+        if (publish) {
+            snapshot->endRows(now);
+            snapshots_.publish();
         }
 
-        prev_stats_ = std::move(current);
+        // Интерфейсы, пропавшие из файла, освобождают слоты
+        for (std::uint32_t slot : active_slots_) {
+            if (seen_tick_[slot] != tick_) {
+                names_.release(slot);
+                slot_state_[slot] = SLOT_UNKNOWN;
+            }
+        }
+        active_slots_.clear();
+        for (const NetInterface& curr : current_stats_) {
+            active_slots_.push_back(curr.slot);
+        }
+        prev_time_ = now;
+        first_run_ = false;
 
     } catch (const std::exception& e) {
-        current_metrics_.clear();
-        prev_stats_.clear();
+        MetricSnapshot& snapshot = snapshots_.beginWrite();
+        snapshot.beginRows();
+        snapshot.endRows(std::chrono::steady_clock::now());
+        snapshots_.publish();
         first_run_ = true;
     }
 }
-
-std::string NetCollector::getFormattedData() {
-    if (current_metrics_.empty()) {
-        return "Network: N/A";
-    }
-
-    std::ostringstream oss;
-    oss << "Network:\n";
-    for (const auto& m : current_metrics_) {
-        // Пропускаем loopback, если не отлаживаем
-        if (m.name == "lo") continue;
-
-        oss << "  " << m.name << ": "
-            << std::fixed << std::setprecision(2)
-            << "↓ " << m.rx_mib_s << " MiB/s, "
-            << "↑ " << m.tx_mib_s << " MiB/s\n";
-    }
-    return oss.str();
-}
\ No newline at end of file
@@ -1,31 +1,71 @@
 #pragma once
 
 #include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
 #include <vector>
+#include "DeviceFilter.hpp"
 #include "Logger.hpp"
+#include "NameTable.hpp"
+#include "ProcReader.hpp"
 #include "IMetricCollector.hpp"
 
+// Счётчики в смысле /proc/net/dev: errs, drop, fifo — как в его столбцах
 struct NetInterface {
-    std::string name;
+    std::uint32_t slot = 0;  // номер имени в NameTable
     std::uint64_t rx_bytes = 0;
+    std::uint64_t rx_packets = 0;
+    std::uint64_t rx_errors = 0;
+    std::uint64_t rx_dropped = 0;
+    std::uint64_t rx_fifo = 0;
+    std::uint64_t rx_multicast = 0;
     std::uint64_t tx_bytes = 0;
+    std::uint64_t tx_packets = 0;
+    std::uint64_t tx_errors = 0;
+    std::uint64_t tx_dropped = 0;
+    std::uint64_t tx_fifo = 0;
 };
 
-struct NetMetrics {
-    std::string name;
-    float rx_mib_s = 0.0;
-    float tx_mib_s = 0.0;
-};
+// Разбирает текст /proc/net/dev в interfaces (в порядке файла), переиспользуя уже
+// выделенные элементы. Имена интерфейсов интернируются в names.
+void readNetDev(std::string_view text, NameTable& names, std::vector<NetInterface>& interfaces);
+
+class NetlinkLinkReader;
+
+// Откуда брать счётчики интерфейсов. AUTO — rtnetlink, если доступен и
+// /proc не подменён через --proc-root, иначе /proc/net/dev.
+enum class NetBackend { PROC, NETLINK, AUTO };
 
 class NetCollector : public IMetricCollector {
 public:
-    explicit NetCollector(std::chrono::milliseconds interval, Logger& logger);
+    // filter отбирает интерфейсы по имени
+    NetCollector(const std::string& proc_root, NetBackend backend, DeviceFilter filter, Logger& logger);
+    ~NetCollector() override;
     void collect() override;
-    std::string getFormattedData() override;
+    SnapshotGuard snapshot() const override { return snapshots_.read(); }
 private:
-    std::chrono::milliseconds interval_;
+    enum SlotState : std::uint8_t { SLOT_UNKNOWN, SLOT_SHOWN, SLOT_HIDDEN };
+
+    // Проходит ли интерфейс слота фильтр; решается один раз, пока слот занят
+    bool showSlot(std::uint32_t slot);
+
     bool first_run_;
-    std::vector<NetInterface> prev_stats_;
-    std::vector<NetMetrics> current_metrics_;
+    // Монотонное время, когда был прочитан предыдущий снимок счётчиков
+    std::chrono::steady_clock::time_point prev_time_;
+    ProcReader netdev_reader_;
+    std::unique_ptr<NetlinkLinkReader> netlink_;  // пусто — читаем /proc/net/dev
+    NameTable names_;
+    std::vector<NetInterface> current_stats_;
+    // Массивы по номеру слота: прошлые счётчики и тик, в котором интерфейс был в файле
+    std::vector<NetInterface> prev_by_slot_;
+    std::vector<std::uint64_t> seen_tick_;
+    std::vector<SlotState> slot_state_;
+    // Слоты из прошлого удачного тика — чтобы освободить пропавшие интерфейсы
+    std::vector<std::uint32_t> active_slots_;
+    std::uint64_t tick_ = 0;
+    DeviceFilter filter_;
+    SnapshotBuffer<MetricSnapshot> snapshots_;
     Logger& logger_;
 };
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "NetlinkLinkReader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <linux/if_link.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+// Ядро собирает дамп в skb не больше 32 КиБ; с запасом
+constexpr std::size_t kInitialBufferSize = 64 * 1024;
+
+// Ответ NLMSG_ERROR; error — положительный errno
+struct NetlinkError : std::runtime_error {
+    NetlinkError(const char* request, int code) :
+    std::runtime_error(std::string(request) + " failed: " + std::strerror(code)),
+    error(code) {}
+    int error;
+};
+
+// Обходит атрибуты rtattr в [data, data + length)
+template<class F>
+void forEachAttribute(const char* data, std::size_t length, F&& on_attribute) {
+    while (length >= sizeof(rtattr)) {
+        rtattr rta;
+        std::memcpy(&rta, data, sizeof(rta));
+        if (rta.rta_len < sizeof(rtattr) || rta.rta_len > length) {
+            return;
+        }
+        on_attribute(rta.rta_type, data + RTA_LENGTH(0), rta.rta_len - RTA_LENGTH(0));
+        std::size_t step = std::min<std::size_t>(RTA_ALIGN(rta.rta_len), length);
+        data += step;
+        length -= step;
+    }
+}
+
+// У старых ядер rtnl_link_stats64 короче — недостающие поля остаются нулями
+void copyStats(rtnl_link_stats64& stats, const char* value, std::size_t length) {
+    stats = rtnl_link_stats64{};
+    std::memcpy(&stats, value, std::min(length, sizeof(stats)));
+}
+
+// Сводим поля так же, как ядро печатает их в /proc/net/dev (dev_seq_printf_stats)
+void fillInterface(NetInterface& iface, const rtnl_link_stats64& stats) {
+    iface.rx_bytes = stats.rx_bytes;
+    iface.rx_packets = stats.rx_packets;
+    iface.rx_errors = stats.rx_errors;
+    iface.rx_dropped = stats.rx_dropped + stats.rx_missed_errors;
+    iface.rx_fifo = stats.rx_fifo_errors;
+    iface.rx_multicast = stats.multicast;
+    iface.tx_bytes = stats.tx_bytes;
+    iface.tx_packets = stats.tx_packets;
+    iface.tx_errors = stats.tx_errors;
+    iface.tx_dropped = stats.tx_dropped;
+    iface.tx_fifo = stats.tx_fifo_errors;
+}
+}
+
+NetlinkLinkReader::NetlinkLinkReader() :
+buffer_(kInitialBufferSize) {
+    fd_ = ::socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open rtnetlink socket");
+    }
+    sockaddr_nl local{};
+    local.nl_family = AF_NETLINK;
+    if (::bind(fd_, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Cannot bind rtnetlink socket");
+    }
+}
+
+NetlinkLinkReader::~NetlinkLinkReader() {
+    ::close(fd_);
+}
+
+template<class F>
+void NetlinkLinkReader::dump(std::uint16_t type, const void* body, std::size_t body_length, F&& on_message) {
+    const char* request_name = (type == RTM_GETLINK) ? "RTM_GETLINK" : "RTM_GETSTATS";
+    char request[NLMSG_HDRLEN + 64] = {};
+    nlmsghdr header{};
+    header.nlmsg_len = NLMSG_LENGTH(body_length);
+    header.nlmsg_type = type;
+    header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    header.nlmsg_seq = ++sequence_;
+    std::memcpy(request, &header, sizeof(header));
+    std::memcpy(request + NLMSG_HDRLEN, body, body_length);
+
+    sockaddr_nl kernel{};
+    kernel.nl_family = AF_NETLINK;
+    while (::sendto(fd_, request, header.nlmsg_len, 0,
+                    reinterpret_cast<sockaddr*>(&kernel), sizeof(kernel)) < 0) {
+        if (errno != EINTR) {
+            throw std::runtime_error(std::string("Cannot send ") + request_name);
+        }
+    }
+
+    while (true) {
+        ssize_t n = ::recv(fd_, buffer_.data(), buffer_.size(), MSG_TRUNC);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot receive rtnetlink dump");
+        }
+        if (static_cast<std::size_t>(n) > buffer_.size()) {
+            // Сообщение обрезано: увеличиваем буфер, остаток дампа отбросится
+            // по номеру запроса при следующем чтении
+            buffer_.resize(static_cast<std::size_t>(n));
+            throw std::runtime_error("rtnetlink message truncated");
+        }
+
+        const char* data = buffer_.data();
+        std::size_t length = static_cast<std::size_t>(n);
+        while (length >= sizeof(nlmsghdr)) {
+            std::memcpy(&header, data, sizeof(header));
+            if (header.nlmsg_len < sizeof(nlmsghdr) || header.nlmsg_len > length) {
+                throw std::runtime_error("Malformed rtnetlink message");
+            }
+            const char* payload = data + NLMSG_HDRLEN;
+            std::size_t payload_length = header.nlmsg_len - NLMSG_HDRLEN;
+            std::size_t step = std::min<std::size_t>(NLMSG_ALIGN(header.nlmsg_len), length);
+            data += step;
+            length -= step;
+
+            // Хвосты прерванных раньше дампов пропускаем по номеру запроса
+            if (header.nlmsg_seq != sequence_) {
+                continue;
+            }
+            if (header.nlmsg_type == NLMSG_DONE) {
+                return;
+            }
+            if (header.nlmsg_type == NLMSG_ERROR) {
+                nlmsgerr error{};
+                std::memcpy(&error, payload, std::min(payload_length, sizeof(error)));
+                throw NetlinkError(request_name, -error.error);
+            }
+            on_message(header.nlmsg_type, payload, payload_length);
+        }
+    }
+}
+
+void NetlinkLinkReader::readLinks(NameTable& names, std::vector<NetInterface>& interfaces) {
+    ifinfomsg request{};
+    request.ifi_family = AF_UNSPEC;
+    std::size_t count = 0;
+    links_.clear();
+    dump(RTM_GETLINK, &request, sizeof(request),
+         [&](std::uint16_t type, const char* payload, std::size_t length) {
+        if (type != RTM_NEWLINK || length < NLMSG_ALIGN(sizeof(ifinfomsg))) {
+            return;
+        }
+        ifinfomsg info;
+        std::memcpy(&info, payload, sizeof(info));
+        std::string_view name;
+        rtnl_link_stats64 stats{};
+        bool has_stats = false;
+        forEachAttribute(payload + NLMSG_ALIGN(sizeof(ifinfomsg)), length - NLMSG_ALIGN(sizeof(ifinfomsg)),
+                         [&](std::uint16_t attr, const char* value, std::size_t value_length) {
+            if (attr == IFLA_IFNAME) {
+                name = std::string_view(value, strnlen(value, value_length));
+            } else if (attr == IFLA_STATS64) {
+                copyStats(stats, value, value_length);
+                has_stats = true;
+            }
+        });
+        if (name.empty() || !has_stats) {
+            return;
+        }
+
+        if (count == interfaces.size()) {
+            interfaces.emplace_back();
+        }
+        NetInterface& iface = interfaces[count++];
+        iface.slot = names.intern(name);
+        fillInterface(iface, stats);
+        links_.push_back(Link{info.ifi_index, iface.slot});
+    });
+    interfaces.resize(count);
+    std::sort(links_.begin(), links_.end(),
+              [](const Link& a, const Link& b) { return a.ifindex < b.ifindex; });
+    reads_since_links_ = 0;
+}
+
+bool NetlinkLinkReader::readStats(std::vector<NetInterface>& interfaces) {
+    if_stats_msg request{};
+    request.family = AF_UNSPEC;
+    request.filter_mask = IFLA_STATS_FILTER_BIT(IFLA_STATS_LINK_64);
+    std::size_t count = 0;
+    bool known = true;
+    dump(RTM_GETSTATS, &request, sizeof(request),
+         [&](std::uint16_t type, const char* payload, std::size_t length) {
+        if (type != RTM_NEWSTATS || length < NLMSG_ALIGN(sizeof(if_stats_msg))) {
+            return;
+        }
+        if_stats_msg header;
+        std::memcpy(&header, payload, sizeof(header));
+        std::vector<Link>::const_iterator link = std::lower_bound(
+            links_.begin(), links_.end(), static_cast<int>(header.ifindex),
+            [](const Link& l, int ifindex) { return l.ifindex < ifindex; });
+        if (link == links_.end() || link->ifindex != static_cast<int>(header.ifindex)) {
+            known = false;
+            return;
+        }
+
+        if (count == interfaces.size()) {
+            interfaces.emplace_back();
+        }
+        NetInterface& iface = interfaces[count];
+        bool has_stats = false;
+        forEachAttribute(payload + NLMSG_ALIGN(sizeof(if_stats_msg)), length - NLMSG_ALIGN(sizeof(if_stats_msg)),
+                         [&](std::uint16_t attr, const char* value, std::size_t value_length) {
+            if (attr == IFLA_STATS_LINK_64) {
+                rtnl_link_stats64 stats;
+                copyStats(stats, value, value_length);
+                fillInterface(iface, stats);
+                has_stats = true;
+            }
+        });
+        if (has_stats) {
+            iface.slot = link->slot;
+            ++count;
+        }
+    });
+    interfaces.resize(count);
+    return known;
+}
+
+void NetlinkLinkReader::read(NameTable& names, std::vector<NetInterface>& interfaces) {
+    bool done = false;
+    if (stats_supported_ && !links_.empty() && ++reads_since_links_ < kNameRefreshReads) {
+        try {
+            done = readStats(interfaces);
+        } catch (const NetlinkError& e) {
+            if (e.error != EOPNOTSUPP && e.error != EINVAL) {
+                throw;
+            }
+            stats_supported_ = false;
+        }
+    }
+    if (!done) {
+        readLinks(names, interfaces);
+    }
+
+    if (interfaces.empty()) {
+        throw std::runtime_error("No network interfaces in rtnetlink dump");
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "NameTable.hpp"
+#include "NetCollector.hpp"
+
+// Счётчики интерфейсов через rtnetlink, без текста /proc/net/dev.
+//
+// Дамп RTM_GETLINK даёт имена и 64-битные IFLA_STATS64, но вместе с ними
+// и всю остальную конфигурацию интерфейса (килобайты на каждый). Поэтому
+// в установившемся режиме читается только RTM_GETSTATS с одним
+// IFLA_STATS_LINK_64, а имена берутся из кеша ifindex -> слот. RTM_GETLINK
+// повторяется, когда появился незнакомый ifindex, раз в kNameRefreshReads
+// чтений (переименования) и всегда — на ядрах без RTM_GETSTATS (< 4.7).
+// Сокет и буфер приёма живут всё время работы и переиспользуются.
+class NetlinkLinkReader {
+public:
+    static constexpr std::size_t kNameRefreshReads = 60;
+
+    NetlinkLinkReader();
+    ~NetlinkLinkReader();
+
+    NetlinkLinkReader(const NetlinkLinkReader&) = delete;
+    NetlinkLinkReader& operator=(const NetlinkLinkReader&) = delete;
+
+    // Заполняет interfaces в порядке дампа, переиспользуя элементы
+    void read(NameTable& names, std::vector<NetInterface>& interfaces);
+
+private:
+    struct Link {
+        int ifindex;
+        std::uint32_t slot;
+    };
+
+    // Отправляет дамп-запрос и передаёт каждое сообщение-ответ в on_message
+    template<class F>
+    void dump(std::uint16_t type, const void* body, std::size_t body_length, F&& on_message);
+    // RTM_GETLINK: имена и счётчики, заодно обновляет links_
+    void readLinks(NameTable& names, std::vector<NetInterface>& interfaces);
+    // RTM_GETSTATS: false, если встретился ifindex не из links_
+    bool readStats(std::vector<NetInterface>& interfaces);
+
+    int fd_ = -1;
+    std::uint32_t sequence_ = 0;
+    std::vector<char> buffer_;
+    std::vector<Link> links_;        // по возрастанию ifindex, из последнего RTM_GETLINK
+    bool stats_supported_ = true;
+    std::size_t reads_since_links_ = 0;
+};
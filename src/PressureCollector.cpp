@@ -0,0 +1,248 @@
+#include "PressureCollector.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace {
+// Порядок столбцов снимка
+enum PressureColumn { COL_SOME_AVG10, COL_SOME_AVG60, COL_SOME_PERCENT,
+                      COL_FULL_AVG10, COL_FULL_AVG60, COL_FULL_PERCENT };
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+// Десятичная дробь вида "1.81" без strtod и локали
+bool parseDecimal(std::string_view s, double& value) {
+    double result = 0;
+    std::size_t i = 0;
+    for (; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+        result = result * 10 + (s[i] - '0');
+    }
+    if (i == 0) {
+        return false;
+    }
+    if (i < s.size() && s[i] == '.') {
+        double scale = 0.1;
+        for (++i; i < s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+            result += (s[i] - '0') * scale;
+            scale *= 0.1;
+        }
+    }
+    value = result;
+    return i == s.size();
+}
+
+struct PressureLine {
+    double avg10 = 0;
+    double avg60 = 0;
+    std::uint64_t total = 0;
+};
+
+// "avg10=1.81 avg60=1.41 avg300=1.07 total=41492663"
+bool parsePressureLine(std::string_view line, PressureLine& out) {
+    bool has_total = false;
+    for (std::string_view token = nextToken(line); !token.empty(); token = nextToken(line)) {
+        std::size_t eq = token.find('=');
+        if (eq == std::string_view::npos) {
+            continue;
+        }
+        std::string_view key = token.substr(0, eq);
+        std::string_view value = token.substr(eq + 1);
+        if (key == "avg10") {
+            parseDecimal(value, out.avg10);
+        } else if (key == "avg60") {
+            parseDecimal(value, out.avg60);
+        } else if (key == "total") {
+            has_total = parseUint(value, out.total);
+        }
+    }
+    return has_total;
+}
+}
+
+PressureCollector::PressureCollector(const std::string& proc_root, Logger& logger) :
+snapshots_(MetricSnapshot(MetricSource::PRESSURE, {
+    MetricId::PSI_SOME_AVG10, MetricId::PSI_SOME_AVG60, MetricId::PSI_SOME_PERCENT,
+    MetricId::PSI_FULL_AVG10, MetricId::PSI_FULL_AVG60, MetricId::PSI_FULL_PERCENT})),
+logger_(logger) {
+    for (const char* name : {"cpu", "memory", "io"}) {
+        Resource resource;
+        resource.name = name;
+        resource.reader = std::make_unique<ProcReader>(proc_root + "/pressure/" + name);
+        resources_.push_back(std::move(resource));
+    }
+    // Без CONFIG_PSI или с psi=0 файлов нет — сообщаем сразу, а не на каждом тике
+    try {
+        resources_[0].reader->read();
+    } catch (const std::exception& e) {
+        logger_.error(e.what());
+        throw std::runtime_error("PSI is not available: " + std::string(e.what()));
+    }
+    logger_.info("PressureCollector start.");
+}
+
+PressureCollector::~PressureCollector() {
+    if (watcher_.joinable()) {
+        std::uint64_t one = 1;
+        ssize_t ignored = ::write(stop_fd_, &one, sizeof(one));
+        (void)ignored;
+        watcher_.join();
+    }
+    if (stop_fd_ >= 0) {
+        ::close(stop_fd_);
+    }
+    for (Resource& resource : resources_) {
+        if (resource.trigger_fd >= 0) {
+            ::close(resource.trigger_fd);
+        }
+    }
+}
+
+bool PressureCollector::watchTriggers(std::chrono::microseconds stall, std::chrono::microseconds window,
+                                      std::function<void()> on_event) {
+    char trigger[64];
+    int length = std::snprintf(trigger, sizeof(trigger), "some %lld %lld",
+                               static_cast<long long>(stall.count()), static_cast<long long>(window.count()));
+    std::size_t armed = 0;
+    for (Resource& resource : resources_) {
+        int fd = ::open(resource.reader->path().c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        // Триггер живёт, пока открыт дескриптор; строка пишется вместе с '\0'
+        if (fd < 0 || ::write(fd, trigger, static_cast<std::size_t>(length) + 1) < 0) {
+            logger_.warning(std::string("Cannot set PSI trigger \"") + trigger + "\" on " +
+                            resource.reader->path() + ": " + std::strerror(errno));
+            if (fd >= 0) {
+                ::close(fd);
+            }
+            continue;
+        }
+        resource.trigger_fd = fd;
+        ++armed;
+    }
+    if (armed == 0) {
+        return false;
+    }
+    stop_fd_ = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (stop_fd_ < 0) {
+        // Без потока-наблюдателя триггеры никто не читает — снимаем их
+        for (Resource& resource : resources_) {
+            if (resource.trigger_fd >= 0) {
+                ::close(resource.trigger_fd);
+                resource.trigger_fd = -1;
+            }
+        }
+        logger_.error("eventfd failed");
+        throw std::runtime_error("eventfd failed");
+    }
+    on_event_ = std::move(on_event);
+    watcher_ = std::thread([this] { watchLoop(); });
+    logger_.info("PSI triggers armed: " + std::string(trigger));
+    return true;
+}
+
+void PressureCollector::watchLoop() {
+    std::vector<pollfd> fds;
+    for (const Resource& resource : resources_) {
+        // Отрицательный fd poll() пропускает
+        fds.push_back(pollfd{resource.trigger_fd, POLLPRI, 0});
+    }
+    fds.push_back(pollfd{stop_fd_, POLLIN, 0});
+
+    while (true) {
+        if (::poll(fds.data(), fds.size(), -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logger_.error("poll() on PSI triggers failed: " + std::string(std::strerror(errno)));
+            return;
+        }
+        if (fds.back().revents != 0) {
+            return;
+        }
+        unsigned fired = 0;
+        for (std::size_t i = 0; i < resources_.size(); ++i) {
+            if (fds[i].revents & POLLERR) {
+                // Ядро сняло триггер (например, файл пропал) — больше не ждём его
+                logger_.warning("PSI trigger on " + resources_[i].reader->path() + " was removed");
+                fds[i].fd = -1;
+            } else if (fds[i].revents & POLLPRI) {
+                fired |= 1u << i;
+            }
+        }
+        if (fired != 0) {
+            events_.fetch_or(fired);
+            on_event_();
+        }
+    }
+}
+
+void PressureCollector::collect() {
+    try {
+        MetricSnapshot* snapshot = nullptr;
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double interval_sec = std::chrono::duration<double>(now - prev_time_).count();
+        if (!first_run_) {
+            snapshot = &snapshots_.beginWrite();
+            snapshot->beginRows();
+        }
+        for (Resource& resource : resources_) {
+            std::string_view text = resource.reader->read();
+            PressureLine some;
+            PressureLine full;
+            bool has_some = false;
+            bool has_full = false;
+            std::string_view line;
+            while (nextLine(text, line)) {
+                std::string_view kind = nextToken(line);
+                if (kind == "some") {
+                    has_some = parsePressureLine(line, some);
+                } else if (kind == "full") {
+                    has_full = parsePressureLine(line, full);
+                }
+            }
+            if (!has_some) {
+                throw std::runtime_error("Malformed " + resource.reader->path());
+            }
+
+            if (snapshot) {
+                // Прирост total (мкс простоя) за реально прошедшее время — точнее avg10
+                // на коротких интервалах
+                std::uint64_t some_diff = (some.total > resource.some_total) ? some.total - resource.some_total : 0;
+                double* row = snapshot->addRow(resource.name);
+                row[COL_SOME_AVG10] = some.avg10;
+                row[COL_SOME_AVG60] = some.avg60;
+                row[COL_SOME_PERCENT] = (interval_sec > 0) ? some_diff / 1e6 / interval_sec * 100.0 : 0.0;
+                if (has_full && resource.has_full) {
+                    std::uint64_t full_diff = (full.total > resource.full_total) ? full.total - resource.full_total : 0;
+                    row[COL_FULL_AVG10] = full.avg10;
+                    row[COL_FULL_AVG60] = full.avg60;
+                    row[COL_FULL_PERCENT] = (interval_sec > 0) ? full_diff / 1e6 / interval_sec * 100.0 : 0.0;
+                } else {
+                    row[COL_FULL_AVG10] = kNaN;
+                    row[COL_FULL_AVG60] = kNaN;
+                    row[COL_FULL_PERCENT] = kNaN;
+                }
+            }
+            resource.some_total = some.total;
+            resource.full_total = full.total;
+            resource.has_full = has_full;
+        }
+        if (snapshot) {
+            snapshot->endRows(now);
+            snapshots_.publish();
+        }
+        prev_time_ = now;
+        first_run_ = false;
+    } catch (const std::exception& e) {
+        logger_.error(e.what());
+        MetricSnapshot& snapshot = snapshots_.beginWrite();
+        snapshot.beginRows();
+        snapshot.endRows(std::chrono::steady_clock::now());
+        snapshots_.publish();
+        first_run_ = true;
+    }
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Logger.hpp"
+#include "ProcReader.hpp"
+#include "IMetricCollector.hpp"
+
+// Ресурсы PSI; номер — бит в маске сработавших триггеров
+enum class PressureResource : unsigned { CPU = 0, MEMORY = 1, IO = 2 };
+
+// Pressure Stall Information из /proc/pressure/{cpu,memory,io}: avg10/avg60
+// строк some и full и доля времени в простое по приросту total.
+//
+// Кроме опроса по расписанию коллектор ставит ядру PSI-триггеры (простой
+// stall за окно window) и ждёт их через poll() в своём потоке. Сработавшие
+// ресурсы копятся в маске; главный цикл забирает её takeEvents() и на время
+// ускоряет опрос остальных коллекторов.
+class PressureCollector : public IMetricCollector {
+public:
+    PressureCollector(const std::string& proc_root, Logger& logger);
+    ~PressureCollector() override;
+
+    PressureCollector(const PressureCollector&) = delete;
+    PressureCollector& operator=(const PressureCollector&) = delete;
+
+    // Ставит триггеры "some <stall> <window>" и запускает поток ожидания;
+    // on_event вызывается из него при каждом срабатывании. false, если
+    // ни один триггер ядро не приняло (без CAP_SYS_RESOURCE окно должно
+    // быть кратно 2 с).
+    bool watchTriggers(std::chrono::microseconds stall, std::chrono::microseconds window,
+                       std::function<void()> on_event);
+    // Маска (1 << PressureResource) сработавших с прошлого вызова ресурсов
+    unsigned takeEvents() { return events_.exchange(0); }
+
+    void collect() override;
+    SnapshotGuard snapshot() const override { return snapshots_.read(); }
+
+private:
+    struct Resource {
+        const char* name;
+        std::unique_ptr<ProcReader> reader;
+        std::uint64_t some_total = 0;   // мкс
+        std::uint64_t full_total = 0;
+        bool has_full = false;          // строки full у cpu нет до 5.13
+        int trigger_fd = -1;
+    };
+
+    void watchLoop();
+
+    std::vector<Resource> resources_;
+    bool first_run_ = true;
+    std::chrono::steady_clock::time_point prev_time_;
+
+    std::function<void()> on_event_;
+    std::atomic<unsigned> events_{0};
+    int stop_fd_ = -1;
+    std::thread watcher_;
+
+    SnapshotBuffer<MetricSnapshot> snapshots_;
+    Logger& logger_;
+};
@@ -0,0 +1,71 @@
+#include "ProcReader.hpp"
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+constexpr std::size_t kInitialBufferSize = 16 * 1024;
+}
+
+ProcReader::ProcReader(std::string path) :
+path_(std::move(path)),
+buffer_(kInitialBufferSize) {
+}
+
+ProcReader::~ProcReader() {
+    close();
+}
+
+void ProcReader::open() {
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Cannot open " + path_);
+    }
+}
+
+void ProcReader::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool ProcReader::readAll(std::size_t& total) {
+    total = 0;
+    while (true) {
+        if (total == buffer_.size()) {
+            // Файл не влез — увеличиваем буфер, дальше он останется этого размера
+            buffer_.resize(buffer_.size() * 2);
+        }
+        ssize_t n = ::pread(fd_, buffer_.data() + total, buffer_.size() - total,
+                            static_cast<off_t>(total));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (n == 0) {
+            return true;
+        }
+        total += static_cast<std::size_t>(n);
+    }
+}
+
+std::string_view ProcReader::read() {
+    if (fd_ < 0) {
+        open();
+    }
+    std::size_t total = 0;
+    if (!readAll(total)) {
+        // Дескриптор мог устареть (например, после пересоздания файла) — открываем заново
+        close();
+        open();
+        if (!readAll(total)) {
+            close();
+            throw std::runtime_error("Cannot read " + path_);
+        }
+    }
+    return std::string_view(buffer_.data(), total);
+}
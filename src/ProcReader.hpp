@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Держит файл из /proc открытым и перечитывает его целиком через pread()
+// в один и тот же буфер. После первых чтений буфер больше не растёт,
+// так что в установившемся режиме read() не выделяет память.
+class ProcReader {
+public:
+    explicit ProcReader(std::string path);
+    ~ProcReader();
+
+    ProcReader(const ProcReader&) = delete;
+    ProcReader& operator=(const ProcReader&) = delete;
+
+    // Содержимое файла; действительно до следующего вызова read().
+    std::string_view read();
+    const std::string& path() const { return path_; }
+
+private:
+    void open();
+    void close();
+    bool readAll(std::size_t& total);
+
+    std::string path_;
+    int fd_ = -1;
+    std::vector<char> buffer_;
+};
+
+// Разбор текста /proc без std::istringstream и локалей.
+
+// Отрезает от text очередную строку (без '\n'). false, если текст кончился.
+inline bool nextLine(std::string_view& text, std::string_view& line) {
+    if (text.empty()) {
+        return false;
+    }
+    std::size_t end = text.find('\n');
+    if (end == std::string_view::npos) {
+        line = text;
+        text = std::string_view();
+    } else {
+        line = text.substr(0, end);
+        text.remove_prefix(end + 1);
+    }
+    return true;
+}
+
+inline bool isSpace(char ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+inline void skipSpaces(std::string_view& s) {
+    std::size_t i = 0;
+    while (i < s.size() && isSpace(s[i])) {
+        ++i;
+    }
+    s.remove_prefix(i);
+}
+
+// Следующее слово, разделённое пробелами; пустое, если слов не осталось.
+inline std::string_view nextToken(std::string_view& s) {
+    skipSpaces(s);
+    std::size_t i = 0;
+    while (i < s.size() && !isSpace(s[i])) {
+        ++i;
+    }
+    std::string_view token = s.substr(0, i);
+    s.remove_prefix(i);
+    return token;
+}
+
+// Читает десятичное беззнаковое число после пробелов. Число должно
+// заканчиваться пробелом или концом строки, иначе возвращается false.
+inline bool parseUint(std::string_view& s, std::uint64_t& value) {
+    skipSpaces(s);
+    std::size_t i = 0;
+    std::uint64_t result = 0;
+    while (i < s.size() && s[i] >= '0' && s[i] <= '9') {
+        result = result * 10 + static_cast<std::uint64_t>(s[i] - '0');
+        ++i;
+    }
+    if (i == 0 || (i < s.size() && !isSpace(s[i]))) {
+        return false;
+    }
+    s.remove_prefix(i);
+    value = result;
+    return true;
+}
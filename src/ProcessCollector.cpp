@@ -0,0 +1,373 @@
+#include "ProcessCollector.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include "ProcReader.hpp"
+#include "ThreadPool.hpp"
+
+namespace {
+// Порядок столбцов снимка
+enum ProcessColumn { COL_PID, COL_CPU, COL_RSS, COL_READ_MIB_S, COL_WRITE_MIB_S };
+
+// Меньше этого числа процессов на часть делить скан невыгодно
+constexpr std::size_t kMinShardSize = 2048;
+// stat процесса — около килобайта даже с длинным comm
+constexpr std::size_t kReadBufferSize = 4096;
+constexpr std::size_t kDirentBufferSize = 64 * 1024;
+
+bool parsePid(const char* name, int& pid) {
+    int value = 0;
+    if (*name == '\0') {
+        return false;
+    }
+    for (; *name != '\0'; ++name) {
+        if (*name < '0' || *name > '9') {
+            return false;
+        }
+        value = value * 10 + (*name - '0');
+    }
+    pid = value;
+    return true;
+}
+}
+
+ProcessCollector::ProcessCollector(const std::string& proc_root, std::size_t top_n, ProcessSort sort, Logger& logger) :
+proc_root_(proc_root),
+top_n_(top_n),
+sort_(sort),
+dirents_(kDirentBufferSize),
+clock_ticks_(sysconf(_SC_CLK_TCK)),
+page_kb_(sysconf(_SC_PAGESIZE) / 1024.0),
+snapshots_(MetricSnapshot(MetricSource::PROCESS, {
+    MetricId::PROC_PID, MetricId::PROC_CPU_PERCENT, MetricId::PROC_RSS_KB,
+    MetricId::PROC_READ_MIB_S, MetricId::PROC_WRITE_MIB_S})),
+logger_(logger) {
+    dir_fd_ = ::open(proc_root_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd_ < 0) {
+        logger_.error("Cannot open " + proc_root_);
+        throw std::runtime_error("Cannot open " + proc_root_);
+    }
+    // Половину свободного лимита дескрипторов отдаём под кеш, остальное — программе
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur > 256) {
+        fd_budget_ = static_cast<std::size_t>(limit.rlim_cur - 256) / 2;
+    }
+    shards_.resize(1);
+    shards_[0].buffer.resize(kReadBufferSize);
+    logger_.info("ProcessCollector start. Top " + std::to_string(top_n_) +
+                 ", cached fd budget " + std::to_string(fd_budget_));
+}
+
+ProcessCollector::~ProcessCollector() {
+    for (Entry& entry : entries_) {
+        closeEntry(entry);
+    }
+    ::close(dir_fd_);
+}
+
+void ProcessCollector::shardAcross(ThreadPool& pool) {
+    pool_ = &pool;
+}
+
+void ProcessCollector::listPids() {
+    if (::lseek(dir_fd_, 0, SEEK_SET) < 0) {
+        throw std::runtime_error("Cannot rewind " + proc_root_);
+    }
+    pids_.clear();
+    while (true) {
+        ssize_t n = getdents64(dir_fd_, dirents_.data(), dirents_.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Cannot list " + proc_root_);
+        }
+        if (n == 0) {
+            break;
+        }
+        for (ssize_t offset = 0; offset < n;) {
+            const dirent64* entry = reinterpret_cast<const dirent64*>(dirents_.data() + offset);
+            int pid = 0;
+            if (parsePid(entry->d_name, pid)) {
+                pids_.push_back(pid);
+            }
+            offset += entry->d_reclen;
+        }
+    }
+    // /proc отдаёт pid по возрастанию, но полагаться на это не будем
+    if (!std::is_sorted(pids_.begin(), pids_.end())) {
+        std::sort(pids_.begin(), pids_.end());
+    }
+}
+
+void ProcessCollector::mergePids() {
+    merged_.clear();
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < entries_.size() || j < pids_.size()) {
+        if (j == pids_.size() || (i < entries_.size() && entries_[i].pid < pids_[j])) {
+            closeEntry(entries_[i++]); // процесс завершился
+        } else if (i == entries_.size() || pids_[j] < entries_[i].pid) {
+            merged_.emplace_back();
+            merged_.back().pid = pids_[j++];
+        } else {
+            merged_.push_back(entries_[i++]);
+            ++j;
+        }
+    }
+    entries_.swap(merged_);
+}
+
+void ProcessCollector::closeEntry(Entry& entry) {
+    for (int* fd : {&entry.stat_fd, &entry.statm_fd, &entry.io_fd}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+            cached_fds_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+long ProcessCollector::readFile(Entry& entry, int& fd, const char* name, Shard& shard) {
+    if (fd >= 0) {
+        ssize_t n = ::pread(fd, shard.buffer.data(), shard.buffer.size(), 0);
+        if (n >= 0) {
+            return n;
+        }
+        // Процесс, к которому привязан дескриптор, завершился; pid мог достаться новому
+        ::close(fd);
+        fd = -1;
+        cached_fds_.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    char path[32];
+    std::snprintf(path, sizeof(path), "%d/%s", entry.pid, name);
+    int file = ::openat(dir_fd_, path, O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        return -1;
+    }
+    ssize_t n = ::pread(file, shard.buffer.data(), shard.buffer.size(), 0);
+    int saved_errno = errno;
+    // Кешируем только тем, кто пережил хотя бы один скан: короткоживущие
+    // процессы не стоят дескриптора
+    bool keep = n >= 0 && entry.scans > 0 &&
+                cached_fds_.fetch_add(1, std::memory_order_relaxed) < fd_budget_;
+    if (keep) {
+        fd = file;
+    } else {
+        if (n >= 0 && entry.scans > 0) {
+            cached_fds_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        ::close(file);
+    }
+    errno = saved_errno;
+    return n;
+}
+
+bool ProcessCollector::readEntry(Entry& entry, Shard& shard, double interval_sec) {
+    entry.valid = false;
+    long n = readFile(entry, entry.stat_fd, "stat", shard);
+    if (n <= 0) {
+        return false;
+    }
+    // comm может содержать пробелы и скобки — ищем последнюю ')'
+    std::string_view text(shard.buffer.data(), static_cast<std::size_t>(n));
+    std::size_t open = text.find('(');
+    std::size_t close = text.rfind(')');
+    if (open == std::string_view::npos || close == std::string_view::npos || close < open) {
+        return false;
+    }
+    std::string_view comm = text.substr(open + 1, close - open - 1);
+    std::string_view fields = text.substr(close + 1);
+    // Поля 3..13 (state ... cmajflt), потом utime и stime, потом 16..21 и starttime
+    for (int i = 0; i < 11; ++i) {
+        nextToken(fields);
+    }
+    std::uint64_t utime = 0;
+    std::uint64_t stime = 0;
+    std::uint64_t start_time = 0;
+    if (!parseUint(fields, utime) || !parseUint(fields, stime)) {
+        return false;
+    }
+    for (int i = 0; i < 6; ++i) {
+        nextToken(fields);
+    }
+    if (!parseUint(fields, start_time)) {
+        return false;
+    }
+
+    if (entry.scans > 0 && start_time != entry.start_time) {
+        // pid переиспользован другим процессом
+        entry.has_prev = false;
+        entry.scans = 0;
+        entry.io_denied = false;
+    }
+    entry.start_time = start_time;
+    std::size_t comm_length = std::min(comm.size(), sizeof(entry.comm) - 1);
+    std::memcpy(entry.comm, comm.data(), comm_length);
+    entry.comm[comm_length] = '\0';
+
+    std::uint64_t resident_pages = 0;
+    n = readFile(entry, entry.statm_fd, "statm", shard);
+    if (n > 0) {
+        std::string_view statm(shard.buffer.data(), static_cast<std::size_t>(n));
+        std::uint64_t size_pages = 0;
+        if (!parseUint(statm, size_pages) || !parseUint(statm, resident_pages)) {
+            resident_pages = 0;
+        }
+    }
+
+    std::uint64_t read_bytes = entry.read_bytes;
+    std::uint64_t write_bytes = entry.write_bytes;
+    if (!entry.io_denied) {
+        n = readFile(entry, entry.io_fd, "io", shard);
+        if (n < 0 && errno == EACCES) {
+            entry.io_denied = true; // чужой процесс без прав — больше не пытаемся
+        }
+        std::string_view io(shard.buffer.data(), n > 0 ? static_cast<std::size_t>(n) : 0);
+        std::string_view line;
+        while (nextLine(io, line)) {
+            std::string_view key = nextToken(line);
+            if (key == "read_bytes:") {
+                parseUint(line, read_bytes);
+            } else if (key == "write_bytes:") {
+                parseUint(line, write_bytes);
+            }
+        }
+    }
+
+    std::uint64_t cpu_ticks = utime + stime;
+    if (entry.has_prev && interval_sec > 0) {
+        std::uint64_t cpu_diff = (cpu_ticks > entry.cpu_ticks) ? cpu_ticks - entry.cpu_ticks : 0;
+        std::uint64_t read_diff = (read_bytes > entry.read_bytes) ? read_bytes - entry.read_bytes : 0;
+        std::uint64_t write_diff = (write_bytes > entry.write_bytes) ? write_bytes - entry.write_bytes : 0;
+        entry.cpu_percent = static_cast<double>(cpu_diff) / clock_ticks_ / interval_sec * 100.0;
+        entry.read_mib_s = read_diff / (1024.0 * 1024.0) / interval_sec;
+        entry.write_mib_s = write_diff / (1024.0 * 1024.0) / interval_sec;
+        entry.valid = true;
+    }
+    entry.rss_kb = resident_pages * page_kb_;
+    entry.cpu_ticks = cpu_ticks;
+    entry.read_bytes = read_bytes;
+    entry.write_bytes = write_bytes;
+    entry.has_prev = true;
+    ++entry.scans;
+    return entry.valid;
+}
+
+double ProcessCollector::rankKey(const Entry& entry) const {
+    switch (sort_) {
+    case ProcessSort::RSS:
+        return entry.rss_kb;
+    case ProcessSort::IO:
+        return entry.read_mib_s + entry.write_mib_s;
+    case ProcessSort::CPU:
+        break;
+    }
+    return entry.cpu_percent;
+}
+
+void ProcessCollector::pushTop(std::vector<Ranked>& top, Ranked item) const {
+    // Min-куча: в вершине — худший из лучших, его и вытесняем
+    auto worse = [](const Ranked& a, const Ranked& b) { return a.key > b.key; };
+    if (top.size() < top_n_) {
+        top.push_back(item);
+        std::push_heap(top.begin(), top.end(), worse);
+    } else if (top_n_ > 0 && item.key > top.front().key) {
+        std::pop_heap(top.begin(), top.end(), worse);
+        top.back() = item;
+        std::push_heap(top.begin(), top.end(), worse);
+    }
+}
+
+void ProcessCollector::scanRange(Shard& shard, std::size_t begin, std::size_t end, double interval_sec) {
+    shard.top.clear();
+    for (std::size_t i = begin; i < end; ++i) {
+        Entry& entry = entries_[i];
+        if (readEntry(entry, shard, interval_sec)) {
+            pushTop(shard.top, Ranked{rankKey(entry), static_cast<std::uint32_t>(i)});
+        }
+    }
+}
+
+void ProcessCollector::collect() {
+    try {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        listPids();
+        mergePids();
+        double interval_sec = first_run_ ? 0.0 : std::chrono::duration<double>(now - prev_time_).count();
+
+        std::size_t count = entries_.size();
+        std::size_t shard_count = 1;
+        if (pool_ != nullptr && count >= 2 * kMinShardSize) {
+            shard_count = std::min(pool_->size(), count / kMinShardSize);
+        }
+        while (shards_.size() < shard_count) {
+            shards_.emplace_back();
+            shards_.back().buffer.resize(kReadBufferSize);
+        }
+
+        if (shard_count == 1) {
+            scanRange(shards_[0], 0, count, interval_sec);
+        } else {
+            // Части — соседние диапазоны pid; каждая ведёт свою кучу top-N
+            std::vector<Task> tasks;
+            tasks.reserve(shard_count);
+            for (std::size_t s = 0; s < shard_count; ++s) {
+                std::size_t begin = count * s / shard_count;
+                std::size_t end = count * (s + 1) / shard_count;
+                tasks.emplace_back([this, s, begin, end, interval_sec] {
+                    scanRange(shards_[s], begin, end, interval_sec);
+                });
+            }
+            pool_->submitAndWait(tasks.data(), tasks.size());
+        }
+
+        top_.clear();
+        for (std::size_t s = 0; s < shard_count; ++s) {
+            for (const Ranked& item : shards_[s].top) {
+                pushTop(top_, item);
+            }
+        }
+        std::sort(top_.begin(), top_.end(), [this](const Ranked& a, const Ranked& b) {
+            if (a.key != b.key) {
+                return a.key > b.key;
+            }
+            return entries_[a.entry].pid < entries_[b.entry].pid;
+        });
+
+        if (!first_run_) {
+            MetricSnapshot& snapshot = snapshots_.beginWrite();
+            snapshot.beginRows();
+            for (const Ranked& item : top_) {
+                const Entry& entry = entries_[item.entry];
+                instance_ = std::to_string(entry.pid);
+                instance_ += ' ';
+                instance_ += entry.comm;
+                double* row = snapshot.addRow(instance_);
+                row[COL_PID] = entry.pid;
+                row[COL_CPU] = entry.cpu_percent;
+                row[COL_RSS] = entry.rss_kb;
+                row[COL_READ_MIB_S] = entry.read_mib_s;
+                row[COL_WRITE_MIB_S] = entry.write_mib_s;
+            }
+            snapshot.endRows(now);
+            snapshots_.publish();
+        }
+        prev_time_ = now;
+        first_run_ = false;
+    } catch (const std::exception& e) {
+        logger_.error(e.what());
+        MetricSnapshot& snapshot = snapshots_.beginWrite();
+        snapshot.beginRows();
+        snapshot.endRows(std::chrono::steady_clock::now());
+        snapshots_.publish();
+    }
+}
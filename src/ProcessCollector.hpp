@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Logger.hpp"
+#include "IMetricCollector.hpp"
+
+class ThreadPool;
+
+// По какой метрике выбирать top-N процессов
+enum class ProcessSort { CPU, RSS, IO };
+
+// Процессы из /proc/[pid]: CPU%, RSS и скорость дискового IO, в снимке —
+// только top-N. Файлы открываются через openat() относительно дескриптора
+// каталога /proc. Долгоживущим процессам (пережившим хотя бы один скан)
+// дескрипторы stat/statm/io оставляются открытыми, пока хватает бюджета,
+// и дальше читаются одним pread(). Список pid сливается с прошлым
+// (оба по возрастанию), так что появление и уход процессов обходятся
+// без перестройки остального состояния.
+class ProcessCollector : public IMetricCollector {
+public:
+    ProcessCollector(const std::string& proc_root, std::size_t top_n, ProcessSort sort, Logger& logger);
+    ~ProcessCollector() override;
+
+    ProcessCollector(const ProcessCollector&) = delete;
+    ProcessCollector& operator=(const ProcessCollector&) = delete;
+
+    // Делить скан на части и выполнять их в пуле (по умолчанию — в одном потоке)
+    void shardAcross(ThreadPool& pool);
+
+    void collect() override;
+    SnapshotGuard snapshot() const override { return snapshots_.read(); }
+
+    std::size_t processCount() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        int pid = 0;
+        int stat_fd = -1;
+        int statm_fd = -1;
+        int io_fd = -1;
+        bool io_denied = false;         // /proc/pid/io чужого процесса без прав
+        bool has_prev = false;
+        bool valid = false;             // прочитан в этом скане
+        std::uint32_t scans = 0;        // сколько сканов процесс жив
+        std::uint64_t start_time = 0;   // поле 22: отличает переиспользованный pid
+        std::uint64_t cpu_ticks = 0;    // utime + stime
+        std::uint64_t read_bytes = 0;
+        std::uint64_t write_bytes = 0;
+        double cpu_percent = 0;
+        double rss_kb = 0;
+        double read_mib_s = 0;
+        double write_mib_s = 0;
+        char comm[64] = {};
+    };
+
+    struct Ranked {
+        double key;
+        std::uint32_t entry;
+    };
+
+    // Рабочее состояние одной части скана
+    struct Shard {
+        std::vector<char> buffer;
+        std::vector<Ranked> top;        // min-куча не больше top_n_ элементов
+    };
+
+    void listPids();
+    void mergePids();
+    void scanRange(Shard& shard, std::size_t begin, std::size_t end, double interval_sec);
+    bool readEntry(Entry& entry, Shard& shard, double interval_sec);
+    // Длина прочитанного или -1; кеширует дескриптор, если процесс долгоживущий
+    long readFile(Entry& entry, int& fd, const char* name, Shard& shard);
+    void closeEntry(Entry& entry);
+    double rankKey(const Entry& entry) const;
+    void pushTop(std::vector<Ranked>& top, Ranked item) const;
+
+    std::string proc_root_;
+    int dir_fd_ = -1;
+    std::size_t top_n_;
+    ProcessSort sort_;
+    ThreadPool* pool_ = nullptr;
+
+    std::vector<char> dirents_;
+    std::vector<int> pids_;             // pid из текущего листинга, по возрастанию
+    std::vector<Entry> entries_;        // по возрастанию pid
+    std::vector<Entry> merged_;         // второй буфер для слияния
+    std::vector<Shard> shards_;
+    std::vector<Ranked> top_;
+
+    std::size_t fd_budget_ = 0;
+    std::atomic<std::size_t> cached_fds_{0};
+    long clock_ticks_;
+    double page_kb_;
+    bool first_run_ = true;
+    std::chrono::steady_clock::time_point prev_time_;
+    std::string instance_;
+
+    SnapshotBuffer<MetricSnapshot> snapshots_;
+    Logger& logger_;
+};
@@ -0,0 +1,98 @@
+#include "SelfCollector.hpp"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace {
+// Порядок столбцов снимка
+enum SelfColumn { COL_CPU, COL_RSS, COL_MISSED, COL_SKIPPED,
+                  COL_CALLS, COL_MEAN_US, COL_P50_US, COL_P99_US, COL_MAX_US };
+constexpr std::size_t kColumns = 9;
+
+constexpr double kNaN = std::numeric_limits<double>::quiet_NaN();
+
+std::chrono::nanoseconds toDuration(const timeval& tv) {
+    return std::chrono::seconds(tv.tv_sec) + std::chrono::microseconds(tv.tv_usec);
+}
+}
+
+SelfCollector::SelfCollector(const CollectorScheduler& scheduler, Logger& logger) :
+scheduler_(scheduler),
+statm_reader_("/proc/self/statm"),
+page_kb_(sysconf(_SC_PAGESIZE) / 1024.0),
+snapshots_(MetricSnapshot(MetricSource::SELF, {
+    MetricId::SELF_CPU_PERCENT, MetricId::SELF_RSS_KB, MetricId::SELF_MISSED_TICKS,
+    MetricId::SELF_SKIPPED, MetricId::SELF_CALLS, MetricId::SELF_MEAN_US,
+    MetricId::SELF_P50_US, MetricId::SELF_P99_US, MetricId::SELF_MAX_US})),
+logger_(logger) {
+    logger_.info("SelfCollector start.");
+}
+
+void SelfCollector::addLatency(std::string name, const LatencyHistogram& histogram) {
+    latencies_.push_back(Latency{std::move(name), &histogram, histogram.load()});
+}
+
+void SelfCollector::collect() {
+    try {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            throw std::runtime_error("getrusage failed");
+        }
+        std::chrono::nanoseconds cpu_time = toDuration(usage.ru_utime) + toDuration(usage.ru_stime);
+
+        std::string_view statm = statm_reader_.read();
+        std::uint64_t size_pages = 0;
+        std::uint64_t resident_pages = 0;
+        if (!parseUint(statm, size_pages) || !parseUint(statm, resident_pages)) {
+            throw std::runtime_error("Malformed /proc/self/statm");
+        }
+
+        if (!first_run_) {
+            double interval_sec = std::chrono::duration<double>(now - prev_time_).count();
+            double cpu_sec = std::chrono::duration<double>(cpu_time - prev_cpu_time_).count();
+
+            MetricSnapshot& snapshot = snapshots_.beginWrite();
+            snapshot.beginRows();
+            double* row = snapshot.addRow("sysmon");
+            std::fill(row, row + kColumns, kNaN);
+            row[COL_CPU] = (interval_sec > 0) ? cpu_sec / interval_sec * 100.0 : 0.0;
+            row[COL_RSS] = resident_pages * page_kb_;
+            row[COL_MISSED] = static_cast<double>(scheduler_.missedTicks());
+            row[COL_SKIPPED] = static_cast<double>(scheduler_.skippedCollections());
+
+            for (Latency& latency : latencies_) {
+                LatencyHistogram::Counts counts = latency.histogram->load();
+                LatencyHistogram::Counts window = counts.since(latency.prev);
+                latency.prev = counts;
+                std::uint64_t calls = window.total();
+
+                row = snapshot.addRow(latency.name);
+                std::fill(row, row + kColumns, kNaN);
+                row[COL_CALLS] = static_cast<double>(calls);
+                row[COL_MEAN_US] = calls > 0 ? window.sum_ns / 1e3 / calls : 0.0;
+                row[COL_P50_US] = window.quantileNs(0.5) / 1e3;
+                row[COL_P99_US] = window.quantileNs(0.99) / 1e3;
+                row[COL_MAX_US] = window.maxNs() / 1e3;
+            }
+            snapshot.endRows(now);
+            snapshots_.publish();
+        } else {
+            for (Latency& latency : latencies_) {
+                latency.prev = latency.histogram->load();
+            }
+        }
+        prev_cpu_time_ = cpu_time;
+        prev_time_ = now;
+        first_run_ = false;
+    } catch (const std::exception& e) {
+        logger_.error(e.what());
+        MetricSnapshot& snapshot = snapshots_.beginWrite();
+        snapshot.beginRows();
+        snapshot.endRows(std::chrono::steady_clock::now());
+        snapshots_.publish();
+        first_run_ = true;
+    }
+}
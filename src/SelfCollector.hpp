@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "CollectorScheduler.hpp"
+#include "LatencyHistogram.hpp"
+#include "Logger.hpp"
+#include "ProcReader.hpp"
+#include "IMetricCollector.hpp"
+
+// Сколько стоит сам sysmon: CPU% и RSS процесса, пропущенные дедлайны
+// планировщика и задержки по гистограммам (сборы коллекторов, ожидание
+// в очереди пула, отрисовка, запись сводки). Первая строка снимка —
+// процесс целиком, дальше по строке на гистограмму с квантилями за
+// интервал между сборами.
+class SelfCollector : public IMetricCollector {
+public:
+    SelfCollector(const CollectorScheduler& scheduler, Logger& logger);
+
+    // Только до первого collect(); строки идут в порядке регистрации
+    void addLatency(std::string name, const LatencyHistogram& histogram);
+
+    void collect() override;
+    SnapshotGuard snapshot() const override { return snapshots_.read(); }
+
+private:
+    struct Latency {
+        std::string name;
+        const LatencyHistogram* histogram;
+        LatencyHistogram::Counts prev;
+    };
+
+    const CollectorScheduler& scheduler_;
+    std::vector<Latency> latencies_;
+    ProcReader statm_reader_;
+    double page_kb_;
+    std::chrono::nanoseconds prev_cpu_time_{0};
+    std::chrono::steady_clock::time_point prev_time_;
+    bool first_run_ = true;
+
+    SnapshotBuffer<MetricSnapshot> snapshots_;
+    Logger& logger_;
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Публикация снимков от одного писателя любому числу читателей без блокировок.
+//
+// Слотов несколько. Писатель заполняет слот, который сейчас никто не
+// читает и который не является последним опубликованным, и публикует его
+// атомарной записью индекса. Читатель отмечается в счётчике слота и
+// перепроверяет, что слот всё ещё последний; если нет — повторяет.
+// Так писатель никогда не трогает слот, который кто-то читает, а читатель
+// всегда видит целиком записанный снимок.
+template <typename T, std::size_t Slots = 4>
+class SnapshotBuffer {
+    static_assert(Slots >= 3, "SnapshotBuffer needs at least 3 slots");
+
+public:
+    class ReadGuard {
+    public:
+        ReadGuard(ReadGuard&& other) noexcept : owner_(other.owner_), slot_(other.slot_) {
+            other.owner_ = nullptr;
+        }
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+        ReadGuard& operator=(ReadGuard&&) = delete;
+        ~ReadGuard() {
+            if (owner_) {
+                owner_->readers_[slot_].fetch_sub(1, std::memory_order_release);
+            }
+        }
+
+        const T& operator*() const { return owner_->slots_[slot_].value; }
+        const T* operator->() const { return &owner_->slots_[slot_].value; }
+        // Номер публикации: растёт на 1 при каждом publish()
+        std::uint64_t sequence() const { return owner_->slots_[slot_].sequence; }
+
+    private:
+        friend class SnapshotBuffer;
+        ReadGuard(const SnapshotBuffer* owner, std::size_t slot) : owner_(owner), slot_(slot) {}
+
+        const SnapshotBuffer* owner_;
+        std::size_t slot_;
+    };
+
+    explicit SnapshotBuffer(const T& initial) {
+        for (Slot& slot : slots_) {
+            slot.value = initial;
+        }
+        for (std::atomic<std::uint32_t>& readers : readers_) {
+            readers.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    SnapshotBuffer(const SnapshotBuffer&) = delete;
+    SnapshotBuffer& operator=(const SnapshotBuffer&) = delete;
+
+    // Только для писателя. Возвращает слот для заполнения; в нём лежит
+    // какой-то из прошлых снимков, так что заполнять нужно целиком.
+    T& beginWrite() {
+        std::size_t latest = latest_.load(std::memory_order_seq_cst);
+        while (true) {
+            for (std::size_t i = 0; i < Slots; ++i) {
+                if (i != latest && readers_[i].load(std::memory_order_seq_cst) == 0) {
+                    writing_ = i;
+                    return slots_[i].value;
+                }
+            }
+            // Все свободные слоты заняты долгими читателями — ждём
+            std::this_thread::yield();
+        }
+    }
+
+    // Только для писателя: делает заполненный слот последним
+    void publish() {
+        slots_[writing_].sequence = ++published_;
+        latest_.store(writing_, std::memory_order_seq_cst);
+    }
+
+    // Последний опубликованный снимок; слот не перезапишут, пока жив guard
+    ReadGuard read() const {
+        while (true) {
+            std::size_t slot = latest_.load(std::memory_order_seq_cst);
+            readers_[slot].fetch_add(1, std::memory_order_seq_cst);
+            if (latest_.load(std::memory_order_seq_cst) == slot) {
+                return ReadGuard(this, slot);
+            }
+            readers_[slot].fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+private:
+    struct Slot {
+        T value;
+        std::uint64_t sequence = 0;
+    };
+
+    std::array<Slot, Slots> slots_;
+    mutable std::array<std::atomic<std::uint32_t>, Slots> readers_;
+    std::atomic<std::size_t> latest_{0};
+    std::size_t writing_ = 0;
+    std::uint64_t published_ = 0;
+};
@@ -0,0 +1,358 @@
+#include "SnapshotFormatter.hpp"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+double cell(const MetricSnapshot& snapshot, std::size_t row, MetricId id) {
+    int column = snapshot.column(id);
+    return (column < 0) ? 0.0 : snapshot.value(row, static_cast<std::size_t>(column));
+}
+
+// Имена одного вида, если совпадают без цифр: "node0" и "node1",
+// но не "socket0" и "socket0.core3"
+bool sameKind(std::string_view a, std::string_view b) {
+    auto isDigit = [](char ch) { return ch >= '0' && ch <= '9'; };
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (true) {
+        while (i < a.size() && isDigit(a[i])) ++i;
+        while (j < b.size() && isDigit(b[j])) ++j;
+        if (i == a.size() || j == b.size()) {
+            return i == a.size() && j == b.size();
+        }
+        if (a[i++] != b[j++]) {
+            return false;
+        }
+    }
+}
+
+void formatCpu(const MetricSnapshot& s, std::string& out) {
+    if (s.rows() == 0) {
+        out += "CPU: N/A\n";
+        return;
+    }
+    out += "CPU ";
+    appendFixed(out, cell(s, 0, MetricId::CPU_CORES), 0);
+    out += ": ";
+    appendFixed(out, cell(s, 0, MetricId::CPU_USAGE_PERCENT), 1);
+    out += "%\n";
+
+    // Из чего складывается загрузка; по ядрам — только в снимке
+    struct Part {
+        const char* label;
+        MetricId id;
+    };
+    static const Part parts[] = {
+        {"user", MetricId::CPU_USER_PERCENT}, {"nice", MetricId::CPU_NICE_PERCENT},
+        {"system", MetricId::CPU_SYSTEM_PERCENT}, {"iowait", MetricId::CPU_IOWAIT_PERCENT},
+        {"irq", MetricId::CPU_IRQ_PERCENT}, {"softirq", MetricId::CPU_SOFTIRQ_PERCENT},
+        {"steal", MetricId::CPU_STEAL_PERCENT}, {"guest", MetricId::CPU_GUEST_PERCENT},
+    };
+    const char* separator = "  ";
+    for (const Part& part : parts) {
+        out += separator;
+        out += part.label;
+        out += ' ';
+        appendFixed(out, cell(s, 0, part.id), 1);
+        out += '%';
+        separator = ", ";
+    }
+    out += '\n';
+
+    // Строки после первой — сводки по узлам, сокетам, ядрам и отдельные CPU;
+    // каждый вид — своей строкой
+    for (std::size_t row = 1; row < s.rows(); ++row) {
+        std::string_view name = s.instances[row];
+        if (row == 1) {
+            out += "  [";
+        } else if (!sameKind(s.instances[row - 1], name)) {
+            out += "]\n  [";
+        } else {
+            out += ", ";
+        }
+        out += name;
+        out += ':';
+        appendFixed(out, cell(s, row, MetricId::CPU_USAGE_PERCENT), 1);
+    }
+    if (s.rows() > 1) {
+        out += "]\n";
+    }
+}
+
+void formatMemory(const MetricSnapshot& s, std::string& out) {
+    if (s.rows() == 0) {
+        out += "Memory: N/A\n";
+        return;
+    }
+    // Переводим в GiB для удобства
+    double total_gb = cell(s, 0, MetricId::MEM_TOTAL_KB) / (1024.0 * 1024.0);
+    double used_gb = cell(s, 0, MetricId::MEM_USED_KB) / (1024.0 * 1024.0);
+
+    out += "Memory:\n  ";
+    appendFixed(out, cell(s, 0, MetricId::MEM_USED_PERCENT), 2);
+    out += "% (";
+    appendFixed(out, used_gb, 2);
+    out += " GiB / ";
+    appendFixed(out, total_gb, 2);
+    out += " GiB)";
+
+    // Опционально: swap
+    if (cell(s, 0, MetricId::SWAP_TOTAL_KB) > 0) {
+        out += " | Swap: ";
+        appendFixed(out, cell(s, 0, MetricId::SWAP_USED_PERCENT), 2);
+        out += '%';
+    }
+    out += '\n';
+
+    // Куда ушла память; на старых ядрах части полей нет (NaN)
+    struct Part {
+        const char* label;
+        MetricId id;
+    };
+    static const Part parts[] = {
+        {"Cached", MetricId::MEM_CACHED_KB}, {"Buffers", MetricId::MEM_BUFFERS_KB},
+        {"Shmem", MetricId::MEM_SHMEM_KB}, {"Slab", MetricId::MEM_SLAB_KB},
+        {"Dirty", MetricId::MEM_DIRTY_KB}, {"Writeback", MetricId::MEM_WRITEBACK_KB},
+        {"Committed", MetricId::MEM_COMMITTED_AS_KB},
+    };
+    const char* separator = "  ";
+    for (const Part& part : parts) {
+        double kb = cell(s, 0, part.id);
+        if (std::isnan(kb)) {
+            continue;
+        }
+        out += separator;
+        out += part.label;
+        out += ' ';
+        appendFixed(out, kb / 1024.0, 1);
+        out += " MiB";
+        separator = ", ";
+    }
+    if (cell(s, 0, MetricId::MEM_HUGEPAGES_TOTAL) > 0) {
+        out += separator;
+        out += "HugePages ";
+        appendFixed(out, cell(s, 0, MetricId::MEM_HUGEPAGES_FREE), 0);
+        out += '/';
+        appendFixed(out, cell(s, 0, MetricId::MEM_HUGEPAGES_TOTAL), 0);
+        out += " free";
+    }
+    out += '\n';
+
+    // Остальные строки — узлы NUMA
+    if (s.rows() > 1) {
+        out += "  [";
+        for (std::size_t row = 1; row < s.rows(); ++row) {
+            if (row > 1) out += ", ";
+            out += s.instances[row];
+            out += ':';
+            appendFixed(out, cell(s, row, MetricId::MEM_USED_PERCENT), 1);
+            out += "% of ";
+            appendFixed(out, cell(s, row, MetricId::MEM_TOTAL_KB) / (1024.0 * 1024.0), 1);
+            out += " GiB";
+        }
+        out += "]\n";
+    }
+}
+
+void formatDisk(const MetricSnapshot& s, std::string& out) {
+    if (s.rows() == 0) {
+        out += "Disk: N/A\n";
+        return;
+    }
+    out += "Disk IO:\n";
+    for (std::size_t row = 0; row < s.rows(); ++row) {
+        out += "  ";
+        out += s.instances[row];
+        out += ": R ";
+        appendFixed(out, cell(s, row, MetricId::DISK_READ_MIB_S), 1);
+        out += " MiB/s, W ";
+        appendFixed(out, cell(s, row, MetricId::DISK_WRITE_MIB_S), 1);
+        out += " MiB/s, Util ";
+        appendFixed(out, cell(s, row, MetricId::DISK_UTIL_PERCENT), 1);
+        out += "%, await R ";
+        appendFixed(out, cell(s, row, MetricId::DISK_READ_AWAIT_MS), 1);
+        out += " / W ";
+        appendFixed(out, cell(s, row, MetricId::DISK_WRITE_AWAIT_MS), 1);
+        out += " ms, queue ";
+        appendFixed(out, cell(s, row, MetricId::DISK_QUEUE_DEPTH), 2);
+        out += '\n';
+    }
+}
+
+void formatNet(const MetricSnapshot& s, std::string& out) {
+    if (s.rows() == 0) {
+        out += "Network: N/A\n";
+        return;
+    }
+    out += "Network:\n";
+    for (std::size_t row = 0; row < s.rows(); ++row) {
+        out += "  ";
+        out += s.instances[row];
+        out += ": ↓ ";
+        appendFixed(out, cell(s, row, MetricId::NET_RX_MIB_S), 2);
+        out += " MiB/s (";
+        appendFixed(out, cell(s, row, MetricId::NET_RX_PACKETS_S), 0);
+        out += " pps), ↑ ";
+        appendFixed(out, cell(s, row, MetricId::NET_TX_MIB_S), 2);
+        out += " MiB/s (";
+        appendFixed(out, cell(s, row, MetricId::NET_TX_PACKETS_S), 0);
+        out += " pps)";
+        // Ошибки и потери обычно нулевые — показываем, только когда они есть
+        double errors = cell(s, row, MetricId::NET_RX_ERRORS_S) + cell(s, row, MetricId::NET_TX_ERRORS_S);
+        double drops = cell(s, row, MetricId::NET_RX_DROPS_S) + cell(s, row, MetricId::NET_TX_DROPS_S);
+        if (errors > 0 || drops > 0) {
+            out += ", errs ";
+            appendFixed(out, errors, 1);
+            out += "/s, drops ";
+            appendFixed(out, drops, 1);
+            out += "/s";
+        }
+        out += '\n';
+    }
+}
+
+void formatProcess(const MetricSnapshot& s, std::string& out) {
+    if (s.rows() == 0) {
+        out += "Processes: N/A\n";
+        return;
+    }
+    out += "Top processes:\n";
+    for (std::size_t row = 0; row < s.rows(); ++row) {
+        out += "  ";
+        out += s.instances[row];
+        out += ": CPU ";
+        appendFixed(out, cell(s, row, MetricId::PROC_CPU_PERCENT), 1);
+        out += "%, RSS ";
+        appendFixed(out, cell(s, row, MetricId::PROC_RSS_KB) / 1024.0, 1);
+        out += " MiB, R ";
+        appendFixed(out, cell(s, row, MetricId::PROC_READ_MIB_S), 1);
+        out += " MiB/s, W ";
+        appendFixed(out, cell(s, row, MetricId::PROC_WRITE_MIB_S), 1);
+        out += " MiB/s\n";
+    }
+}
+
+void formatCgroup(const MetricSnapshot& s, std::string& out) {
+    if (s.rows() == 0) {
+        out += "Cgroups: N/A\n";
+        return;
+    }
+    out += "Cgroups:\n";
+    for (std::size_t row = 0; row < s.rows(); ++row) {
+        out += "  ";
+        out += s.instances[row];
+        out += ": CPU ";
+        appendFixed(out, cell(s, row, MetricId::CG_CPU_PERCENT), 1);
+        out += '%';
+        // Контроллеры memory и io могут быть не включены для группы (NaN)
+        double memory_kb = cell(s, row, MetricId::CG_MEMORY_KB);
+        if (!std::isnan(memory_kb)) {
+            out += ", Mem ";
+            appendFixed(out, memory_kb / 1024.0, 1);
+            out += " MiB";
+        }
+        double read_mib_s = cell(s, row, MetricId::CG_READ_MIB_S);
+        if (!std::isnan(read_mib_s)) {
+            out += ", R ";
+            appendFixed(out, read_mib_s, 1);
+            out += " MiB/s, W ";
+            appendFixed(out, cell(s, row, MetricId::CG_WRITE_MIB_S), 1);
+            out += " MiB/s";
+        }
+        out += '\n';
+    }
+}
+
+void formatPressure(const MetricSnapshot& s, std::string& out) {
+    if (s.rows() == 0) {
+        out += "Pressure: N/A\n";
+        return;
+    }
+    // Доля времени, когда хоть одна (some) или все (full) задачи ждали ресурс
+    out += "Pressure (stalled %, now / avg10 / avg60):\n";
+    for (std::size_t row = 0; row < s.rows(); ++row) {
+        out += "  ";
+        out += s.instances[row];
+        out += ": some ";
+        appendFixed(out, cell(s, row, MetricId::PSI_SOME_PERCENT), 2);
+        out += " / ";
+        appendFixed(out, cell(s, row, MetricId::PSI_SOME_AVG10), 2);
+        out += " / ";
+        appendFixed(out, cell(s, row, MetricId::PSI_SOME_AVG60), 2);
+        if (!std::isnan(cell(s, row, MetricId::PSI_FULL_PERCENT))) {
+            out += ", full ";
+            appendFixed(out, cell(s, row, MetricId::PSI_FULL_PERCENT), 2);
+            out += " / ";
+            appendFixed(out, cell(s, row, MetricId::PSI_FULL_AVG10), 2);
+            out += " / ";
+            appendFixed(out, cell(s, row, MetricId::PSI_FULL_AVG60), 2);
+        }
+        out += '\n';
+    }
+}
+
+void formatSelf(const MetricSnapshot& s, std::string& out) {
+    if (s.rows() == 0) {
+        out += "Sysmon: N/A\n";
+        return;
+    }
+    out += "Sysmon: CPU ";
+    appendFixed(out, cell(s, 0, MetricId::SELF_CPU_PERCENT), 2);
+    out += "%, RSS ";
+    appendFixed(out, cell(s, 0, MetricId::SELF_RSS_KB) / 1024.0, 1);
+    out += " MiB, missed ";
+    appendFixed(out, cell(s, 0, MetricId::SELF_MISSED_TICKS), 0);
+    out += '\n';
+    // Остальные строки — задержки за интервал, в микросекундах
+    for (std::size_t row = 1; row < s.rows(); ++row) {
+        out += "  ";
+        out += s.instances[row];
+        out += ": ";
+        appendFixed(out, cell(s, row, MetricId::SELF_CALLS), 0);
+        out += " calls, p50 ";
+        appendFixed(out, cell(s, row, MetricId::SELF_P50_US), 0);
+        out += " us, p99 ";
+        appendFixed(out, cell(s, row, MetricId::SELF_P99_US), 0);
+        out += " us, max ";
+        appendFixed(out, cell(s, row, MetricId::SELF_MAX_US), 0);
+        out += " us\n";
+    }
+}
+}
+
+void appendFixed(std::string& out, double value, int precision) {
+    char buf[64];
+    int length = std::snprintf(buf, sizeof(buf), "%.*f", precision, value);
+    if (length > 0) {
+        out.append(buf, static_cast<std::size_t>(length));
+    }
+}
+
+void formatSnapshot(const MetricSnapshot& snapshot, std::string& out) {
+    switch (snapshot.source) {
+    case MetricSource::CPU:
+        formatCpu(snapshot, out);
+        break;
+    case MetricSource::MEMORY:
+        formatMemory(snapshot, out);
+        break;
+    case MetricSource::DISK:
+        formatDisk(snapshot, out);
+        break;
+    case MetricSource::NET:
+        formatNet(snapshot, out);
+        break;
+    case MetricSource::PROCESS:
+        formatProcess(snapshot, out);
+        break;
+    case MetricSource::CGROUP:
+        formatCgroup(snapshot, out);
+        break;
+    case MetricSource::PRESSURE:
+        formatPressure(snapshot, out);
+        break;
+    case MetricSource::SELF:
+        formatSelf(snapshot, out);
+        break;
+    }
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include "MetricSnapshot.hpp"
+
+// Человекочитаемый текст снимка для экрана и сводки в логе.
+// Дописывает в out, ничего не выделяя, если у out хватает ёмкости.
+void formatSnapshot(const MetricSnapshot& snapshot, std::string& out);
+
+// Число с фиксированным количеством знаков после запятой
+void appendFixed(std::string& out, double value, int precision);
@@ -0,0 +1,67 @@
+#include "StabilityTracker.hpp"
+#include <algorithm>
+#include <cmath>
+#include <string_view>
+
+namespace {
+bool endsWith(std::string_view name, std::string_view suffix) {
+    return name.size() >= suffix.size() && name.substr(name.size() - suffix.size()) == suffix;
+}
+}
+
+// Единица метрики видна по суффиксу её имени. Порог — заметное изменение
+// в этой единице: сотые доли процента или килобайты в секунду — шум, а
+// переход 0.2% -> 1.1% CPU или 0.05 -> 0.95 MiB/s — уже пробуждение.
+double StabilityTracker::changeFloor(MetricId id) {
+    std::string_view name = metricName(id);
+    if (endsWith(name, "_percent") || endsWith(name, "_avg10") || endsWith(name, "_avg60")) {
+        return 0.5;
+    }
+    if (endsWith(name, "_mib_s")) {
+        return 0.05;
+    }
+    if (endsWith(name, "_ms") || endsWith(name, "_depth")) {
+        return 0.1;
+    }
+    if (endsWith(name, "_us")) {
+        return 10.0;
+    }
+    if (endsWith(name, "_kb")) {
+        return 64.0;
+    }
+    if (endsWith(name, "_s") || endsWith(name, "_iops")) {
+        return 1.0;
+    }
+    // Счётчики и размеры (ядра, pid, страницы) — любое изменение
+    return 0.0;
+}
+
+bool StabilityTracker::update(const MetricSnapshot& snapshot) {
+    if (columns_ != snapshot.columns) {
+        columns_ = snapshot.columns;
+        floors_.clear();
+        for (MetricId id : columns_) {
+            floors_.push_back(changeFloor(id));
+        }
+        has_reference_ = false;
+    }
+    bool changed = !has_reference_ || snapshot.instances != instances_ ||
+                   snapshot.values.size() != values_.size();
+    std::size_t width = floors_.size();
+    for (std::size_t i = 0; !changed && i < values_.size(); ++i) {
+        double before = values_[i];
+        double now = snapshot.values[i];
+        if (std::isnan(before) || std::isnan(now)) {
+            changed = std::isnan(before) != std::isnan(now);
+            continue;
+        }
+        double diff = std::fabs(now - before);
+        changed = diff > floors_[i % width] && diff > tolerance_ * std::max(std::fabs(before), std::fabs(now));
+    }
+    if (changed) {
+        instances_ = snapshot.instances;
+        values_ = snapshot.values;
+        has_reference_ = true;
+    }
+    return changed;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "MetricSnapshot.hpp"
+
+// Следит, остаются ли значения снимков в полосе допуска вокруг опорного
+// снимка. Опорный — последний, на котором было замечено изменение, так что
+// медленный дрейф тоже рано или поздно выходит за полосу.
+class StabilityTracker {
+public:
+    // tolerance — допустимое относительное отклонение (0.05 = 5%); изменения
+    // не больше changeFloor(метрики) не считаются никогда
+    explicit StabilityTracker(double tolerance) : tolerance_(tolerance) {}
+
+    // Наименьшее изменение, которое что-то значит, в единицах метрики
+    static double changeFloor(MetricId id);
+
+    // true, если снимок вышел за полосу (или поменялся набор строк);
+    // тогда он становится новым опорным
+    bool update(const MetricSnapshot& snapshot);
+
+private:
+    double tolerance_;
+    bool has_reference_ = false;
+    std::vector<MetricId> columns_;
+    std::vector<double> floors_;    // changeFloor по столбцам
+    std::vector<std::string> instances_;
+    std::vector<double> values_;
+};
@@ -0,0 +1,191 @@
+#include "StreamWriter.hpp"
+#include <cerrno>
+#include <charconv>
+#include <cmath>
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+// Запас под одно число: кратчайшее представление double короче 25 символов
+constexpr std::size_t kNumberChars = 32;
+
+std::int64_t nanoseconds(std::chrono::nanoseconds duration) {
+    return static_cast<std::int64_t>(duration.count());
+}
+
+void appendNumber(std::string& out, double value) {
+    std::size_t size = out.size();
+    out.resize(size + kNumberChars);
+    char* begin = &out[size];
+    std::to_chars_result result = std::to_chars(begin, begin + kNumberChars, value);
+    out.resize(size + static_cast<std::size_t>(result.ptr - begin));
+}
+
+// Секунды эпохи Unix с миллисекундами
+void appendWallTime(std::string& out, std::int64_t wall_ns) {
+    std::int64_t wall_ms = wall_ns / 1000000;
+    std::size_t size = out.size();
+    out.resize(size + kNumberChars);
+    char* begin = &out[size];
+    char* p = std::to_chars(begin, begin + kNumberChars, wall_ms / 1000).ptr;
+    std::int64_t ms = wall_ms % 1000;
+    *p++ = '.';
+    *p++ = static_cast<char>('0' + ms / 100);
+    *p++ = static_cast<char>('0' + ms / 10 % 10);
+    *p++ = static_cast<char>('0' + ms % 10);
+    out.resize(size + static_cast<std::size_t>(p - begin));
+}
+}
+
+StreamWriter::StreamWriter(int fd, StreamFormat format) :
+fd_(fd),
+format_(format),
+wall_offset_ns_(nanoseconds(std::chrono::system_clock::now().time_since_epoch()) -
+                nanoseconds(std::chrono::steady_clock::now().time_since_epoch())) {
+    if (::fcntl(fd_, F_GETFD) < 0) {
+        throw std::runtime_error("Output fd " + std::to_string(fd_) + " is not open");
+    }
+    out_.reserve(64 * 1024);
+    if (format_ == StreamFormat::CSV) {
+        out_ += "time,source,instance,metric,value\n";
+    }
+}
+
+bool StreamWriter::write(const std::vector<std::unique_ptr<IMetricCollector>>& collectors,
+                         std::chrono::steady_clock::time_point now) {
+    sequences_.resize(collectors.size(), 0);
+    time_.clear();
+    appendWallTime(time_, nanoseconds(now.time_since_epoch()) + wall_offset_ns_);
+
+    std::size_t start = out_.size();
+    if (format_ == StreamFormat::NDJSON) {
+        out_ += "{\"time\":";
+        out_ += time_;
+    }
+    bool changed = false;
+    for (std::size_t i = 0; i < collectors.size(); ++i) {
+        SnapshotGuard snapshot = collectors[i]->snapshot();
+        if (snapshot.sequence() == 0 || snapshot.sequence() == sequences_[i]) {
+            continue;
+        }
+        sequences_[i] = snapshot.sequence();
+        changed = true;
+        if (format_ == StreamFormat::NDJSON) {
+            appendJson(*snapshot);
+        } else {
+            appendCsv(*snapshot);
+        }
+    }
+    if (!changed) {
+        out_.resize(start);
+        return true;
+    }
+    if (format_ == StreamFormat::NDJSON) {
+        out_ += "}\n";
+    }
+    return flush();
+}
+
+void StreamWriter::appendJson(const MetricSnapshot& snapshot) {
+    out_ += ",\"";
+    out_ += sourceName(snapshot.source);
+    out_ += "\":{";
+    for (std::size_t row = 0; row < snapshot.rows(); ++row) {
+        if (row > 0) {
+            out_ += ',';
+        }
+        appendJsonString(snapshot.instances[row]);
+        out_ += ":{";
+        for (std::size_t column = 0; column < snapshot.columns.size(); ++column) {
+            if (column > 0) {
+                out_ += ',';
+            }
+            out_ += '"';
+            out_ += metricName(snapshot.columns[column]);
+            out_ += "\":";
+            double value = snapshot.value(row, column);
+            if (std::isfinite(value)) {
+                appendNumber(out_, value);
+            } else {
+                out_ += "null";
+            }
+        }
+        out_ += '}';
+    }
+    out_ += '}';
+}
+
+void StreamWriter::appendCsv(const MetricSnapshot& snapshot) {
+    const char* source = sourceName(snapshot.source);
+    for (std::size_t row = 0; row < snapshot.rows(); ++row) {
+        for (std::size_t column = 0; column < snapshot.columns.size(); ++column) {
+            out_ += time_;
+            out_ += ',';
+            out_ += source;
+            out_ += ',';
+            appendCsvField(snapshot.instances[row]);
+            out_ += ',';
+            out_ += metricName(snapshot.columns[column]);
+            out_ += ',';
+            // Нет значения (NaN) — пустое поле
+            double value = snapshot.value(row, column);
+            if (std::isfinite(value)) {
+                appendNumber(out_, value);
+            }
+            out_ += '\n';
+        }
+    }
+}
+
+void StreamWriter::appendJsonString(std::string_view s) {
+    static const char kHex[] = "0123456789abcdef";
+    out_ += '"';
+    for (char ch : s) {
+        unsigned char byte = static_cast<unsigned char>(ch);
+        if (ch == '"' || ch == '\\') {
+            out_ += '\\';
+            out_ += ch;
+        } else if (byte < 0x20) {
+            out_ += "\\u00";
+            out_ += kHex[byte >> 4];
+            out_ += kHex[byte & 0xF];
+        } else {
+            out_ += ch;
+        }
+    }
+    out_ += '"';
+}
+
+// Поле в кавычках, только если в нём есть разделитель, кавычка или перевод строки
+void StreamWriter::appendCsvField(std::string_view s) {
+    if (s.find_first_of(",\"\r\n") == std::string_view::npos) {
+        out_ += s;
+        return;
+    }
+    out_ += '"';
+    for (char ch : s) {
+        if (ch == '"') {
+            out_ += '"';
+        }
+        out_ += ch;
+    }
+    out_ += '"';
+}
+
+bool StreamWriter::flush() {
+    std::size_t written = 0;
+    while (written < out_.size()) {
+        ssize_t n = ::write(fd_, out_.data() + written, out_.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            out_.clear();
+            return false;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    out_.clear();
+    return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "IMetricCollector.hpp"
+#include "MetricSnapshot.hpp"
+
+enum class StreamFormat { NDJSON, CSV };
+
+// Машиночитаемый поток снимков (--output) для передачи другим программам.
+// Каждый тик — одна запись без управляющих последовательностей терминала:
+// в NDJSON строка {"time":...,"cpu":{"total":{"cpu.usage_percent":...}}},
+// в CSV — строки time,source,instance,metric,value (набор строк снимков
+// меняется на ходу, поэтому таблица «длинная»). В запись попадают только
+// коллекторы с новым снимком. Числа печатает std::to_chars прямо в
+// переиспользуемый буфер, и весь тик уходит одним write().
+class StreamWriter {
+public:
+    StreamWriter(int fd, StreamFormat format);
+
+    StreamWriter(const StreamWriter&) = delete;
+    StreamWriter& operator=(const StreamWriter&) = delete;
+
+    // Дописывает запись за тик now; false, если fd больше не принимает данные
+    bool write(const std::vector<std::unique_ptr<IMetricCollector>>& collectors,
+               std::chrono::steady_clock::time_point now);
+
+private:
+    void appendJson(const MetricSnapshot& snapshot);
+    void appendCsv(const MetricSnapshot& snapshot);
+    void appendJsonString(std::string_view s);
+    void appendCsvField(std::string_view s);
+    bool flush();
+
+    int fd_;
+    StreamFormat format_;
+    std::int64_t wall_offset_ns_;           // CLOCK_REALTIME - CLOCK_MONOTONIC при старте
+    std::vector<std::uint64_t> sequences_;  // номер последнего выведенного снимка коллектора
+    std::string time_;                      // время тика, напечатанное один раз
+    std::string out_;
+};
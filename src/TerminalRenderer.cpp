@@ -0,0 +1,165 @@
+#include "TerminalRenderer.hpp"
+#include <cerrno>
+#include <algorithm>
+#include <cstdio>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+bool isContinuation(char ch) {
+    return (static_cast<unsigned char>(ch) & 0xC0) == 0x80;
+}
+
+// Число ячеек (символов UTF-8) в строке
+std::size_t cellCount(std::string_view s) {
+    std::size_t cells = 0;
+    for (char ch : s) {
+        if (!isContinuation(ch)) {
+            ++cells;
+        }
+    }
+    return cells;
+}
+
+// Обрезает строку до max_cells символов, не разрывая многобайтовые
+std::string_view clipCells(std::string_view s, std::size_t max_cells) {
+    std::size_t cells = 0;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        if (!isContinuation(s[i])) {
+            if (cells == max_cells) {
+                return s.substr(0, i);
+            }
+            ++cells;
+        }
+    }
+    return s;
+}
+}
+
+TerminalRenderer::TerminalRenderer(int fd) :
+fd_(fd) {
+    updateSize();
+    // Альтернативный буфер и скрытый курсор; экран очистит первый render()
+    out_ = "\x1b[?1049h\x1b[?25l";
+    writeOut();
+}
+
+TerminalRenderer::~TerminalRenderer() {
+    out_ = "\x1b[0m\x1b[?25h\x1b[?1049l";
+    writeOut();
+}
+
+void TerminalRenderer::invalidate() {
+    updateSize();
+    full_redraw_ = true;
+}
+
+void TerminalRenderer::updateSize() {
+    winsize ws{};
+    if (ioctl(fd_, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 0 && ws.ws_col > 0) {
+        rows_ = ws.ws_row;
+        cols_ = ws.ws_col;
+    } else {
+        // Не терминал — ограничений нет
+        rows_ = static_cast<std::size_t>(-1);
+        cols_ = static_cast<std::size_t>(-1);
+    }
+}
+
+void TerminalRenderer::moveTo(std::size_t row, std::size_t col) {
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "\x1b[%zu;%zuH", row + 1, col + 1);
+    out_.append(buf, static_cast<std::size_t>(n));
+}
+
+void TerminalRenderer::diffLine(std::size_t row, const std::string& old_line, std::string_view new_line) {
+    std::string_view old_view(old_line);
+    if (old_view == new_line) {
+        return;
+    }
+
+    // Общий префикс, выровненный на начало символа
+    std::size_t first = 0;
+    std::size_t limit = std::min(old_view.size(), new_line.size());
+    while (first < limit && old_view[first] == new_line[first]) {
+        ++first;
+    }
+    while (first > 0 && first < new_line.size() && isContinuation(new_line[first])) {
+        --first;
+    }
+
+    std::size_t end = new_line.size();
+    bool clear_tail = true;
+    if (old_view.size() == new_line.size()) {
+        // Та же длина: пробуем не трогать и общий суффикс
+        std::size_t last = new_line.size();
+        while (last > first && old_view[last - 1] == new_line[last - 1]) {
+            --last;
+        }
+        while (last < new_line.size() && isContinuation(new_line[last])) {
+            ++last;
+        }
+        if (cellCount(old_view.substr(first, last - first)) ==
+            cellCount(new_line.substr(first, last - first))) {
+            end = last;
+            clear_tail = false;
+        }
+    }
+
+    moveTo(row, cellCount(new_line.substr(0, first)));
+    out_.append(new_line.data() + first, end - first);
+    if (clear_tail && cellCount(old_view) > cellCount(new_line)) {
+        out_ += "\x1b[K";
+    }
+}
+
+void TerminalRenderer::render(std::string_view frame) {
+    if (full_redraw_) {
+        out_ += "\x1b[H\x1b[2J";
+        for (std::string& line : back_buffer_) {
+            line.clear();
+        }
+        full_redraw_ = false;
+    }
+
+    std::size_t row = 0;
+    while (row < rows_ && !frame.empty()) {
+        std::size_t end = frame.find('\n');
+        std::string_view line = frame.substr(0, end);
+        frame.remove_prefix(end == std::string_view::npos ? frame.size() : end + 1);
+        line = clipCells(line, cols_);
+
+        if (row == back_buffer_.size()) {
+            back_buffer_.emplace_back();
+        }
+        diffLine(row, back_buffer_[row], line);
+        back_buffer_[row].assign(line.data(), line.size());
+        ++row;
+    }
+
+    // Строки, которых в новом кадре уже нет
+    for (std::size_t i = row; i < back_buffer_.size(); ++i) {
+        if (!back_buffer_[i].empty()) {
+            moveTo(i, 0);
+            out_ += "\x1b[K";
+            back_buffer_[i].clear();
+        }
+    }
+
+    writeOut();
+}
+
+void TerminalRenderer::writeOut() {
+    std::size_t written = 0;
+    while (written < out_.size()) {
+        ssize_t n = ::write(fd_, out_.data() + written, out_.size() - written);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        written += static_cast<std::size_t>(n);
+    }
+    out_.clear();
+}
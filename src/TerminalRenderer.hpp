@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Рисует кадр в альтернативном буфере терминала без clear и без мерцания.
+// Хранит предыдущий кадр построчно и на каждом render() отправляет
+// только изменившиеся ячейки (символы UTF-8) одним write().
+class TerminalRenderer {
+public:
+    explicit TerminalRenderer(int fd);
+    ~TerminalRenderer();
+
+    TerminalRenderer(const TerminalRenderer&) = delete;
+    TerminalRenderer& operator=(const TerminalRenderer&) = delete;
+
+    // frame — строки, разделённые '\n'
+    void render(std::string_view frame);
+
+    // Перечитать размер терминала и перерисовать всё на следующем render()
+    void invalidate();
+
+private:
+    void updateSize();
+    void diffLine(std::size_t row, const std::string& old_line, std::string_view new_line);
+    void moveTo(std::size_t row, std::size_t col);
+    void writeOut();
+
+    int fd_;
+    std::size_t rows_ = 0;
+    std::size_t cols_ = 0;
+    bool full_redraw_ = true;
+    std::vector<std::string> back_buffer_;
+    std::string out_;
+};
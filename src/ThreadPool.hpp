@@ -1,7 +1,6 @@
 #pragma once
 
 #include <vector>
-#include <queue>
 #include <thread>
 #include <functional>
 #include <future>
@@ -10,44 +9,224 @@
 #include <stdexcept>
 #include <type_traits>
 #include <tuple>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <pthread.h>
+#include "LatencyHistogram.hpp"
+#include <sched.h>
 
+// Задача пула. Замыкание до kInlineSize байт хранится прямо в объекте,
+// поэтому постановка такой задачи в очередь не выделяет память.
+// Более крупные замыкания уходят в кучу.
+class Task {
+public:
+    static constexpr std::size_t kInlineSize = 48;
+
+    Task() = default;
+
+    template<class F, class = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+    Task(F&& f) {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= kInlineSize &&
+                      alignof(Fn) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Fn>) {
+            new (storage_) Fn(std::forward<F>(f));
+            ops_ = &inlineOps<Fn>;
+        } else {
+            new (storage_) Fn*(new Fn(std::forward<F>(f)));
+            ops_ = &heapOps<Fn>;
+        }
+    }
+
+    Task(Task&& other) noexcept : ops_(other.ops_) {
+        if (ops_) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+
+    Task& operator=(Task&& other) noexcept {
+        if (this != &other) {
+            reset();
+            ops_ = other.ops_;
+            if (ops_) {
+                ops_->move(storage_, other.storage_);
+                other.ops_ = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+
+    ~Task() { reset(); }
+
+    void operator()() { ops_->invoke(storage_); }
+    explicit operator bool() const { return ops_ != nullptr; }
+
+    void reset() {
+        if (ops_) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void*);
+        void (*move)(void* dst, void* src); // перемещает и разрушает src
+        void (*destroy)(void*);
+    };
+
+    template<class Fn>
+    static constexpr Ops inlineOps = {
+        [](void* p) { (*static_cast<Fn*>(p))(); },
+        [](void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* p) { static_cast<Fn*>(p)->~Fn(); },
+    };
+
+    template<class Fn>
+    static constexpr Ops heapOps = {
+        [](void* p) { (**static_cast<Fn**>(p))(); },
+        [](void* dst, void* src) { new (dst) Fn*(*static_cast<Fn**>(src)); },
+        [](void* p) { delete *static_cast<Fn**>(p); },
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_ = nullptr;
+};
+
+// Счётчик-защёлка: wait() возвращается, когда countDown() вызван count раз.
+// Уменьшение идёт под мьютексом, поэтому после wait() защёлку можно
+// разрушать: последний countDown() к ней уже не обратится.
+class CountdownLatch {
+public:
+    explicit CountdownLatch(std::size_t count) : count_(count) {}
+
+    void countDown() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            done_.notify_all();
+        }
+    }
+
+    bool tryWait() const { return count_.load(std::memory_order_acquire) == 0; }
+
+    template<class Rep, class Period>
+    bool waitFor(const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return done_.wait_for(lock, timeout, [this] { return tryWait(); });
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return tryWait(); });
+    }
+
+private:
+    std::atomic<std::size_t> count_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+};
+
+// Пул с очередью на каждого рабочего и кражей задач.
+// Рабочий берёт свои задачи с хвоста (LIFO, горячий кеш), а простаивающие
+// рабочие крадут чужие с головы. Очереди — кольца фиксированной ёмкости,
+// выделенные заранее. Время от постановки задачи до её взятия пишется
+// в гистограмму queueWait().
 class ThreadPool {
 public:
-    explicit ThreadPool(size_t num_threads) : stop_(false) {
+    static constexpr std::size_t kQueueCapacity = 1024;
+
+    // cpus — на какие CPU закреплять рабочих (по кругу); пусто — не закреплять
+    explicit ThreadPool(size_t num_threads, const std::vector<int>& cpus = {}) : stop_(false) {
         if (num_threads == 0) {
             throw std::invalid_argument("ThreadPool size must be > 0");
         }
+        for (int cpu : cpus) {
+            if (cpu < 0 || cpu >= CPU_SETSIZE) {
+                throw std::invalid_argument("CPU " + std::to_string(cpu) + " is out of range");
+            }
+        }
+        queues_.reserve(num_threads);
+        for (size_t i = 0; i < num_threads; ++i) {
+            queues_.push_back(std::make_unique<WorkerQueue>());
+        }
         workers_.reserve(num_threads);
         for (size_t i = 0; i < num_threads; ++i) {
-            workers_.emplace_back([this] {
-                while (true) {
-                    std::function<void()> task;
-                    {
-                        std::unique_lock<std::mutex> lock(queue_mutex_);
-                        condition_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
-                        if (stop_ && tasks_.empty()) {
-                            return;
-                        }
-                        task = std::move(tasks_.front());
-                        tasks_.pop();
-                    }
-                    task();
+            workers_.emplace_back([this, i] { workerLoop(i); });
+            if (!cpus.empty()) {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpus[i % cpus.size()], &set);
+                if (pthread_setaffinity_np(workers_.back().native_handle(), sizeof(set), &set) != 0) {
+                    // Уже запущенные рабочие должны завершиться до исключения,
+                    // иначе деструктор joinable std::thread вызовет terminate
+                    stopWorkers();
+                    throw std::runtime_error("Cannot pin ThreadPool worker to CPU " +
+                                             std::to_string(cpus[i % cpus.size()]));
                 }
-            });
+            }
         }
     }
 
     ~ThreadPool() {
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            stop_ = true;
+        stopWorkers();
+    }
+
+    // Поставить задачу без результата. Для замыканий до Task::kInlineSize байт
+    // память не выделяется.
+    void submit(Task task) {
+        if (stop_) {
+            throw std::runtime_error("submit() called on stopped ThreadPool");
         }
-        condition_.notify_all();
-        for (auto& worker : workers_) {
-            if (worker.joinable()) {
-                worker.join();
+        // Из рабочего потока — в свою очередь, снаружи — по кругу
+        std::size_t start = (current_pool_ == this)
+            ? current_worker_
+            : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+        // Счётчик растёт до вставки, чтобы вор не увёл задачу раньше, чем её учли
+        pending_.fetch_add(1, std::memory_order_seq_cst);
+        std::uint64_t now = nowNs();
+        for (std::size_t i = 0; i < queues_.size(); ++i) {
+            if (queues_[(start + i) % queues_.size()]->push(task, now)) {
+                notifyOne();
+                return;
+            }
+        }
+        pending_.fetch_sub(1, std::memory_order_seq_cst);
+        // Все очереди полны — выполняем в вызывающем потоке
+        task();
+    }
+
+    // Выполнить count задач и дождаться всех. Вместо future на каждую
+    // задачу — одна защёлка. Ждущий поток сам выполняет задачи из пула,
+    // поэтому вызывать можно и изнутри задачи пула.
+    void submitAndWait(Task* tasks, std::size_t count) {
+        CountdownLatch latch(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            Task* task = &tasks[i];
+            submit([task, &latch] {
+                (*task)();
+                latch.countDown();
+            });
+        }
+        while (!latch.tryWait()) {
+            Task task;
+            if (takeTask(task)) {
+                task();
+            } else {
+                latch.waitFor(std::chrono::microseconds(200));
             }
         }
+        latch.wait();
     }
 
     template<class F, class... Args>
@@ -63,21 +242,134 @@ public:
         );
 
         std::future<return_type> res = task->get_future();
-        {
-            std::unique_lock<std::mutex> lock(queue_mutex_);
-            if (stop_) {
-                throw std::runtime_error("enqueue() called on stopped ThreadPool");
-            }
-            tasks_.emplace([task]() { (*task)(); });
+        if (stop_) {
+            throw std::runtime_error("enqueue() called on stopped ThreadPool");
         }
-        condition_.notify_one();
+        submit([task]() { (*task)(); });
         return res;
     }
 
+    std::size_t size() const { return workers_.size(); }
+    // Сколько задачи ждали в очереди до начала выполнения
+    const LatencyHistogram& queueWait() const { return queue_wait_; }
+
 private:
+    void stopWorkers() {
+        {
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    // Кольцо задач под собственным мьютексом; владелец работает с хвостом,
+    // воры — с головы
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::vector<Task> ring = std::vector<Task>(kQueueCapacity);
+        std::vector<std::uint64_t> enqueued_ns = std::vector<std::uint64_t>(kQueueCapacity);
+        std::size_t head = 0;
+        std::size_t tail = 0;
+
+        bool push(Task& task, std::uint64_t now) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail - head == ring.size()) {
+                return false;
+            }
+            enqueued_ns[tail % ring.size()] = now;
+            ring[tail++ % ring.size()] = std::move(task);
+            return true;
+        }
+        bool popBack(Task& task, std::uint64_t& enqueued) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail == head) {
+                return false;
+            }
+            --tail;
+            enqueued = enqueued_ns[tail % ring.size()];
+            task = std::move(ring[tail % ring.size()]);
+            return true;
+        }
+        bool stealFront(Task& task, std::uint64_t& enqueued) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (tail == head) {
+                return false;
+            }
+            enqueued = enqueued_ns[head % ring.size()];
+            task = std::move(ring[head++ % ring.size()]);
+            return true;
+        }
+    };
+
+    static std::uint64_t nowNs() {
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    // Своя очередь (если поток — рабочий этого пула), затем кража у остальных
+    bool takeTask(Task& task) {
+        if (pending_.load(std::memory_order_seq_cst) == 0) {
+            return false;
+        }
+        std::size_t self = (current_pool_ == this) ? current_worker_ : 0;
+        std::uint64_t enqueued = 0;
+        bool taken = current_pool_ == this && queues_[self]->popBack(task, enqueued);
+        for (std::size_t i = 1; !taken && i <= queues_.size(); ++i) {
+            taken = queues_[(self + i) % queues_.size()]->stealFront(task, enqueued);
+        }
+        if (!taken) {
+            return false;
+        }
+        pending_.fetch_sub(1, std::memory_order_seq_cst);
+        std::uint64_t now = nowNs();
+        queue_wait_.record(now > enqueued ? now - enqueued : 0);
+        return true;
+    }
+
+    void notifyOne() {
+        if (sleeping_.load(std::memory_order_seq_cst) > 0) {
+            // Пустая секция: рабочий либо ещё не проверил pending_, либо уже спит
+            { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+            wake_.notify_one();
+        }
+    }
+
+    void workerLoop(std::size_t index) {
+        current_pool_ = this;
+        current_worker_ = index;
+        while (true) {
+            Task task;
+            if (takeTask(task)) {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            sleeping_.fetch_add(1, std::memory_order_seq_cst);
+            wake_.wait(lock, [this] {
+                return stop_ || pending_.load(std::memory_order_seq_cst) > 0;
+            });
+            sleeping_.fetch_sub(1, std::memory_order_seq_cst);
+            if (stop_ && pending_.load(std::memory_order_seq_cst) == 0) {
+                return;
+            }
+        }
+    }
+
+    static inline thread_local ThreadPool* current_pool_ = nullptr;
+    static inline thread_local std::size_t current_worker_ = 0;
+
     std::vector<std::thread> workers_;
-    std::queue<std::function<void()>> tasks_;
-    std::mutex queue_mutex_;
-    std::condition_variable condition_;
-    bool stop_;
-};
\ No newline at end of file
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::atomic<std::size_t> next_queue_{0};
+    std::atomic<std::size_t> pending_{0};
+    std::atomic<std::size_t> sleeping_{0};
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> stop_;
+    LatencyHistogram queue_wait_;
+};
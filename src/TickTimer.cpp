@@ -0,0 +1,72 @@
+#include "TickTimer.hpp"
+#include <cerrno>
+#include <cstdint>
+#include <ctime>
+#include <stdexcept>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+TickTimer::TickTimer() {
+    fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("timerfd_create failed");
+    }
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ < 0) {
+        close(fd_);
+        throw std::runtime_error("eventfd failed");
+    }
+}
+
+TickTimer::~TickTimer() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+}
+
+void TickTimer::wake() {
+    std::uint64_t one = 1;
+    ssize_t ignored = write(wake_fd_, &one, sizeof(one));
+    (void)ignored;
+}
+
+bool TickTimer::waitUntil(std::chrono::steady_clock::time_point deadline) {
+    // steady_clock в libstdc++ — это CLOCK_MONOTONIC, эпохи совпадают
+    std::chrono::nanoseconds ns = deadline.time_since_epoch();
+    if (ns.count() <= 0) {
+        return true;
+    }
+
+    itimerspec spec{};
+    spec.it_value.tv_sec = static_cast<time_t>(ns.count() / 1000000000);
+    spec.it_value.tv_nsec = static_cast<long>(ns.count() % 1000000000);
+    if (timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0) {
+        throw std::runtime_error("timerfd_settime failed");
+    }
+
+    pollfd fds[2] = {{fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    if (poll(fds, 2, -1) < 0) {
+        if (errno == EINTR) {
+            return false;
+        }
+        throw std::runtime_error("poll failed");
+    }
+
+    std::uint64_t counter = 0;
+    if (fds[1].revents & POLLIN) {
+        // Сбрасываем счётчик пробуждений
+        ssize_t ignored = read(wake_fd_, &counter, sizeof(counter));
+        (void)ignored;
+    }
+    if (fds[0].revents & POLLIN) {
+        ssize_t ignored = read(fd_, &counter, sizeof(counter));
+        (void)ignored;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <chrono>
+
+// Таймер на timerfd с абсолютными дедлайнами (CLOCK_MONOTONIC).
+// Ожидание привязано к моменту времени, а не к длительности, поэтому
+// период не «плывёт» от того, сколько длилась работа между тиками.
+class TickTimer {
+public:
+    TickTimer();
+    ~TickTimer();
+
+    TickTimer(const TickTimer&) = delete;
+    TickTimer& operator=(const TickTimer&) = delete;
+
+    // Блокируется до deadline; если он уже прошёл — возвращается сразу.
+    // false, если ожидание прервал сигнал или вызов wake().
+    bool waitUntil(std::chrono::steady_clock::time_point deadline);
+
+    // Досрочно будит waitUntil(); можно звать из любого потока
+    void wake();
+
+private:
+    int fd_ = -1;
+    int wake_fd_ = -1;
+};
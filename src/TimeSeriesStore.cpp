@@ -0,0 +1,295 @@
+#include "TimeSeriesStore.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+namespace {
+constexpr std::uint32_t kBlockBits = TimeSeriesStore::kBlockWords * 64;
+constexpr std::uint8_t kNoWindow = 64;
+
+std::uint64_t lowMask(unsigned count) {
+    return (count >= 64) ? ~0ull : (1ull << count) - 1;
+}
+
+// Биты пишутся от младших к старшим: первый записанный бит — младший бит слова
+void putBits(std::uint64_t* words, std::uint32_t& position, std::uint64_t value, unsigned count) {
+    value &= lowMask(count);
+    std::uint32_t word = position / 64;
+    unsigned offset = position % 64;
+    words[word] |= value << offset;
+    if (offset + count > 64) {
+        words[word + 1] |= value >> (64 - offset);
+    }
+    position += count;
+}
+
+std::uint64_t getBits(const std::uint64_t* words, std::uint32_t& position, unsigned count) {
+    std::uint32_t word = position / 64;
+    unsigned offset = position % 64;
+    std::uint64_t value = words[word] >> offset;
+    if (offset + count > 64) {
+        value |= words[word + 1] << (64 - offset);
+    }
+    position += count;
+    return value & lowMask(count);
+}
+
+// Код разности разностей времени: префикс из единиц, затем число со сдвигом.
+// Префикс пишется одним вызовом — биты в нём идут в порядке чтения.
+struct TimeCode {
+    std::uint64_t prefix;
+    unsigned prefix_bits;
+    unsigned value_bits;
+    std::int64_t bias;
+};
+
+constexpr TimeCode kTimeCodes[] = {
+    {0b0, 1, 0, 0},             // 0
+    {0b01, 2, 7, 63},           // [-63, 64]
+    {0b011, 3, 9, 255},         // [-255, 256]
+    {0b0111, 4, 12, 2047},      // [-2047, 2048]
+    {0b1111, 4, 64, 0},         // остальное — целиком
+};
+
+const TimeCode& timeCode(std::int64_t dod) {
+    for (std::size_t i = 0; i + 1 < std::size(kTimeCodes); ++i) {
+        const TimeCode& code = kTimeCodes[i];
+        if (dod >= -code.bias && dod <= code.bias + ((code.value_bits > 0) ? 1 : 0)) {
+            return code;
+        }
+    }
+    return kTimeCodes[std::size(kTimeCodes) - 1];
+}
+
+std::uint64_t doubleBits(double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double bitsDouble(std::uint64_t bits) {
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+}
+
+TimeSeriesStore::TimeSeriesStore(std::size_t budget_bytes) :
+max_blocks_(std::min<std::size_t>(budget_bytes / sizeof(Block), kNoBlock - 1)) {
+    if (max_blocks_ == 0) {
+        throw std::invalid_argument("History budget is smaller than one block (" +
+                                    std::to_string(sizeof(Block)) + " bytes)");
+    }
+    // Только резерв адресов: страницы занимаются по мере заполнения блоков
+    blocks_.reserve(max_blocks_);
+}
+
+void TimeSeriesStore::mapCells(std::size_t source_index, const MetricSnapshot& snapshot) {
+    SourceLayout& layout = layouts_[source_index];
+    std::vector<std::uint32_t> previous;
+    previous.swap(layout.series);
+    layout.instances = snapshot.instances;
+    layout.columns = snapshot.columns;
+    for (std::size_t row = 0; row < snapshot.rows(); ++row) {
+        for (MetricId id : snapshot.columns) {
+            key_ = sourceName(snapshot.source);
+            key_ += '/';
+            key_ += snapshot.instances[row];
+            key_ += '/';
+            key_ += metricName(id);
+            std::uint32_t series = keys_.intern(key_);
+            series_.resize(keys_.slotCount());
+            series_[series].users++;
+            layout.series.push_back(series);
+        }
+    }
+    // Счётчики новой раскладки уже учтены — ряды, оставшиеся только в старой, можно отпустить
+    for (std::uint32_t series : previous) {
+        series_[series].users--;
+        releaseIfUnused(series);
+    }
+}
+
+void TimeSeriesStore::releaseIfUnused(std::uint32_t series) {
+    Series& s = series_[series];
+    if (s.users == 0 && s.head == kNoBlock) {
+        keys_.release(series);
+        s = Series();
+    }
+}
+
+void TimeSeriesStore::append(std::size_t source_index, const MetricSnapshot& snapshot) {
+    if (source_index >= layouts_.size()) {
+        layouts_.resize(source_index + 1);
+    }
+    // Карту ячеек пересчитываем, только если набор строк изменился
+    SourceLayout& layout = layouts_[source_index];
+    if (layout.instances != snapshot.instances || layout.columns != snapshot.columns) {
+        mapCells(source_index, snapshot);
+    }
+    std::int64_t time_ms = static_cast<std::int64_t>(snapshot.timestamp_ns / 1000000);
+    for (std::size_t cell = 0; cell < layout.series.size(); ++cell) {
+        appendSample(layout.series[cell], time_ms, snapshot.values[cell]);
+    }
+}
+
+void TimeSeriesStore::appendSample(std::uint32_t series, std::int64_t time_ms, double value) {
+    Series& s = series_[series];
+    std::uint64_t bits = doubleBits(value);
+    if (s.tail == kNoBlock) {
+        openBlock(series, time_ms, bits);
+        return;
+    }
+
+    std::int64_t delta = time_ms - s.prev_ms;
+    const TimeCode& time_code = timeCode(delta - s.prev_delta);
+    unsigned needed = time_code.prefix_bits + time_code.value_bits;
+
+    // Значение: 0 — то же; 10 — значащие биты в прошлом окне; 11 — новое окно
+    std::uint64_t x = bits ^ s.prev_value;
+    unsigned leading = 0;
+    unsigned trailing = 0;
+    bool reuse = false;
+    if (x == 0) {
+        needed += 1;
+    } else {
+        leading = std::min(static_cast<unsigned>(__builtin_clzll(x)), 31u);
+        trailing = static_cast<unsigned>(__builtin_ctzll(x));
+        reuse = s.leading != kNoWindow && leading >= s.leading && trailing >= s.trailing;
+        needed += reuse ? 2 + (64 - s.leading - s.trailing) : 2 + 5 + 6 + (64 - leading - trailing);
+    }
+
+    Block& block = blocks_[s.tail];
+    if (block.bits + needed > kBlockBits) {
+        openBlock(series, time_ms, bits);
+        return;
+    }
+
+    putBits(block.words, block.bits, time_code.prefix, time_code.prefix_bits);
+    if (time_code.value_bits > 0) {
+        putBits(block.words, block.bits,
+                static_cast<std::uint64_t>(delta - s.prev_delta + time_code.bias), time_code.value_bits);
+    }
+    if (x == 0) {
+        putBits(block.words, block.bits, 0, 1);
+    } else if (reuse) {
+        putBits(block.words, block.bits, 0b01, 2);
+        putBits(block.words, block.bits, x >> s.trailing, 64 - s.leading - s.trailing);
+    } else {
+        unsigned meaningful = 64 - leading - trailing;
+        putBits(block.words, block.bits, 0b11, 2);
+        putBits(block.words, block.bits, leading, 5);
+        putBits(block.words, block.bits, meaningful & 63, 6);  // 64 хранится как 0
+        putBits(block.words, block.bits, x >> trailing, meaningful);
+        s.leading = static_cast<std::uint8_t>(leading);
+        s.trailing = static_cast<std::uint8_t>(trailing);
+    }
+
+    block.count++;
+    block.last_ms = time_ms;
+    s.prev_delta = delta;
+    s.prev_ms = time_ms;
+    s.prev_value = bits;
+    samples_++;
+}
+
+void TimeSeriesStore::openBlock(std::uint32_t series, std::int64_t time_ms, std::uint64_t value) {
+    std::uint32_t index;
+    if (blocks_.size() < max_blocks_) {
+        index = static_cast<std::uint32_t>(blocks_.size());
+        blocks_.emplace_back();
+    } else {
+        // Самый старый блок по кругу — всегда первый в своём ряду
+        index = static_cast<std::uint32_t>(next_victim_);
+        next_victim_ = (next_victim_ + 1) % max_blocks_;
+        Block& victim = blocks_[index];
+        Series& owner = series_[victim.series];
+        owner.head = victim.next;
+        if (owner.tail == index) {
+            owner.tail = kNoBlock;
+        }
+        samples_ -= victim.count;
+        evicted_blocks_++;
+        if (victim.series != series) {
+            releaseIfUnused(victim.series);
+        }
+    }
+
+    Block& block = blocks_[index];
+    block.series = series;
+    block.next = kNoBlock;
+    block.count = 1;
+    block.bits = 0;
+    block.first_ms = time_ms;
+    block.last_ms = time_ms;
+    block.first_value = value;
+    std::fill(std::begin(block.words), std::end(block.words), 0);
+
+    Series& s = series_[series];
+    if (s.tail != kNoBlock) {
+        blocks_[s.tail].next = index;
+    } else {
+        s.head = index;
+    }
+    s.tail = index;
+    s.prev_ms = time_ms;
+    s.prev_delta = 0;
+    s.prev_value = value;
+    s.leading = kNoWindow;
+    s.trailing = 0;
+    samples_++;
+}
+
+void TimeSeriesStore::query(std::uint32_t series, std::int64_t from_ms, std::int64_t to_ms,
+                            std::vector<SeriesSample>& out) const {
+    if (series >= series_.size()) {
+        return;
+    }
+    for (std::uint32_t index = series_[series].head; index != kNoBlock; index = blocks_[index].next) {
+        const Block& block = blocks_[index];
+        if (block.first_ms > to_ms) {
+            break;
+        }
+        if (block.last_ms < from_ms) {
+            continue;
+        }
+
+        // Декодер повторяет состояние кодировщика с начала блока
+        std::int64_t time_ms = block.first_ms;
+        std::int64_t delta = 0;
+        std::uint64_t value = block.first_value;
+        unsigned leading = kNoWindow;
+        unsigned trailing = 0;
+        std::uint32_t position = 0;
+        for (std::uint32_t i = 0; i < block.count; ++i) {
+            if (i > 0) {
+                unsigned ones = 0;
+                while (ones < 4 && getBits(block.words, position, 1) == 1) {
+                    ++ones;
+                }
+                const TimeCode& code = kTimeCodes[ones];
+                if (code.value_bits > 0) {
+                    delta += static_cast<std::int64_t>(getBits(block.words, position, code.value_bits)) - code.bias;
+                }
+                time_ms += delta;
+
+                if (getBits(block.words, position, 1) == 1) {
+                    if (getBits(block.words, position, 1) == 1) {
+                        leading = static_cast<unsigned>(getBits(block.words, position, 5));
+                        unsigned meaningful = static_cast<unsigned>(getBits(block.words, position, 6));
+                        meaningful = (meaningful == 0) ? 64 : meaningful;
+                        trailing = 64 - leading - meaningful;
+                    }
+                    value ^= getBits(block.words, position, 64 - leading - trailing) << trailing;
+                }
+            }
+            if (time_ms > to_ms) {
+                return;
+            }
+            if (time_ms >= from_ms) {
+                out.push_back(SeriesSample{time_ms, bitsDouble(value)});
+            }
+        }
+    }
+}
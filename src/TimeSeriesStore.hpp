@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MetricSnapshot.hpp"
+#include "NameTable.hpp"
+
+struct SeriesSample {
+    std::int64_t time_ms;   // CLOCK_MONOTONIC, миллисекунды
+    double value;
+};
+
+// История всех метрик в памяти процесса, сжатая как в Gorilla (Facebook, 2015).
+// Ряд — одна (источник, строка, метрика), ключ "cpu/cpu3/cpu.usage_percent".
+// Точки ряда пишутся в блоки фиксированного размера: время — разность
+// разностей в миллисекундах (ровный шаг стоит 1 бит), значение — XOR с
+// предыдущим (неизменное стоит 1 бит, похожее — только значащие биты).
+//
+// Все блоки лежат в одном массиве, размер которого задан бюджетом памяти.
+// Массив заполняется по кругу: когда он полон, новый блок занимает место
+// самого старого, так что вытесняются всегда самые старые данные и в
+// установившемся режиме запись не выделяет память. Ряд, у которого не
+// осталось ни точек, ни строки в снимках, освобождает свой ключ.
+class TimeSeriesStore {
+public:
+    static constexpr std::uint32_t kNoSeries = NameTable::kNoSlot;
+    // Полезная нагрузка блока в 64-битных словах
+    static constexpr std::size_t kBlockWords = 32;
+
+    // budget_bytes — предел памяти под блоки (метаданные рядов сверх него)
+    explicit TimeSeriesStore(std::size_t budget_bytes);
+
+    TimeSeriesStore(const TimeSeriesStore&) = delete;
+    TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+    // Дописывает все значения снимка в момент snapshot.timestamp_ns.
+    // source_index — номер коллектора: по нему кешируется, какой ряд у какой ячейки.
+    void append(std::size_t source_index, const MetricSnapshot& snapshot);
+
+    // Номер ряда по ключу или kNoSeries
+    std::uint32_t findSeries(std::string_view key) const { return keys_.find(key); }
+    // Точки ряда с from_ms по to_ms включительно, по возрастанию времени
+    void query(std::uint32_t series, std::int64_t from_ms, std::int64_t to_ms,
+               std::vector<SeriesSample>& out) const;
+
+    std::size_t seriesCount() const { return keys_.size(); }
+    // Точек в памяти сейчас и байт блоков под них
+    std::uint64_t samples() const { return samples_; }
+    std::size_t bytesUsed() const { return blocks_.size() * sizeof(Block); }
+    std::size_t budgetBytes() const { return max_blocks_ * sizeof(Block); }
+    std::uint64_t evictedBlocks() const { return evicted_blocks_; }
+    // Размер блока. Бюджет меньше, чем по блоку на ряд, не вмещает даже открытые
+    // блоки: они вытесняют друг друга, и в каждом остаётся по одной точке.
+    static constexpr std::size_t blockBytes() { return sizeof(Block); }
+
+private:
+    static constexpr std::uint32_t kNoBlock = UINT32_MAX;
+
+    struct Block {
+        std::uint32_t series;
+        std::uint32_t next;         // следующий (более новый) блок ряда
+        std::uint32_t count;        // точек в блоке
+        std::uint32_t bits;         // занято бит в words
+        std::int64_t first_ms;      // первая точка хранится целиком
+        std::int64_t last_ms;
+        std::uint64_t first_value;
+        std::uint64_t words[kBlockWords];
+    };
+
+    // Состояние кодировщика открытого (последнего) блока ряда
+    struct Series {
+        std::uint32_t head = kNoBlock;
+        std::uint32_t tail = kNoBlock;
+        std::int64_t prev_ms = 0;
+        std::int64_t prev_delta = 0;
+        std::uint64_t prev_value = 0;
+        std::uint8_t leading = 64;  // окно значащих битов прошлого XOR;
+        std::uint8_t trailing = 0;  // leading == 64 — окна ещё нет
+        std::uint32_t users = 0;    // в скольких раскладках снимков есть ряд
+    };
+
+    // Какие ряды у ячеек снимка одного коллектора
+    struct SourceLayout {
+        std::vector<std::string> instances;
+        std::vector<MetricId> columns;
+        std::vector<std::uint32_t> series;  // по ячейкам, как values снимка
+    };
+
+    void mapCells(std::size_t source_index, const MetricSnapshot& snapshot);
+    // Ряд без точек, которого нет ни в одном снимке (ушедший процесс), забывается
+    void releaseIfUnused(std::uint32_t series);
+    void appendSample(std::uint32_t series, std::int64_t time_ms, double value);
+    // Новый блок в конце ряда, при нехватке бюджета — на месте самого старого
+    void openBlock(std::uint32_t series, std::int64_t time_ms, std::uint64_t value);
+
+    std::size_t max_blocks_;
+    std::size_t next_victim_ = 0;   // индекс самого старого блока, когда массив полон
+    std::vector<Block> blocks_;
+    std::vector<Series> series_;
+    NameTable keys_;
+    std::vector<SourceLayout> layouts_;
+    std::string key_;
+    std::uint64_t samples_ = 0;
+    std::uint64_t evicted_blocks_ = 0;
+};
@@ -1,32 +1,148 @@
 // g++ src/main.cpp src/CpuCollector.cpp src/MemoryCollector.cpp src/DiskCollector.cpp -o sysmon
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
 #include <iostream>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <chrono>
+#include <cstdint>
+#include <optional>
 #include <thread>
 #include <vector>
 
 #include "ThreadPool.hpp"
+#include "CollectorScheduler.hpp"
+#include "TerminalRenderer.hpp"
+#include "SnapshotFormatter.hpp"
+#include "StreamWriter.hpp"
+#include "TimeSeriesStore.hpp"
+#include "ProcReader.hpp"
 #include "Logger.hpp"
+#include "MetricRecorder.hpp"
+#include "Fixture.hpp"
 #include "CpuCollector.hpp"
 #include "MemoryCollector.hpp"
 #include "DiskCollector.hpp"
 #include "NetCollector.hpp"
+#include "ProcessCollector.hpp"
+#include "StabilityTracker.hpp"
+#include "SelfCollector.hpp"
+#include "CgroupCollector.hpp"
+#include "PressureCollector.hpp"
+
+namespace {
+volatile std::sig_atomic_t g_stop_requested = 0;
+volatile std::sig_atomic_t g_resized = 0;
+
+void onSignal(int signo) {
+    if (signo == SIGWINCH) {
+        g_resized = 1;
+    } else {
+        g_stop_requested = 1;
+    }
+}
+
+// Без SA_RESTART: сигнал прерывает ожидание таймера, и цикл сразу видит флаг
+void installSignalHandlers() {
+    struct sigaction sa{};
+    sa.sa_handler = onSignal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGWINCH, &sa, nullptr);
+}
+
+// Сигналы должен получать главный поток: только его ожидание они прерывают.
+// Потоки наследуют маску, поэтому до их запуска сигналы блокируются,
+// а после — снова открываются в главном потоке.
+void setSignalsBlocked(bool blocked) {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGINT);
+    sigaddset(&set, SIGTERM);
+    sigaddset(&set, SIGWINCH);
+    pthread_sigmask(blocked ? SIG_BLOCK : SIG_UNBLOCK, &set, nullptr);
+}
+
+// Пора ли выпускать запись за тик: все сборы закончились, и коллекторы тика
+// попадут в одну запись, или сборы идут без перерыва уже целый интервал.
+// pending — когда пришёл первый ещё не выпущенный снимок; {} — таких нет.
+bool tickReady(std::chrono::steady_clock::time_point& pending, std::chrono::steady_clock::time_point now,
+               bool collecting, std::chrono::milliseconds interval) {
+    if (pending == std::chrono::steady_clock::time_point{}) {
+        pending = now;
+    }
+    if (collecting && now - pending < interval) {
+        return false;
+    }
+    pending = {};
+    return true;
+}
+}
 
 // Функция для вывода справки
 void printHelp() {
   std::cout
       << "Usage: sysmon [OPTIONS]\n"
+      << "       sysmon dump <file>                   Print a --record file as CSV\n"
+      << "       sysmon replay <file> [--speed=<x>]   Play a --record file back on screen\n"
+      << "       sysmon fixture capture <dir> [--frames=<n>] [-i=<interval>] [--proc-root=<dir>]\n"
+      << "       sysmon fixture generate <dir> [--frames=<n>] [--cpus=<n>] [--disks=<n>] [--interfaces=<n>]\n"
+      << "       sysmon fixture replay <dir> [--rounds=<n>] [--per-core]\n"
       << "Options:\n"
       << "  help                Show this help message\n"
       << "  version             Show version\n"
       << "  -i=<duration>       Set update interval (e.g., -i=1s, -i=200ms)\n"
       << "  --interval=<duration> Same as -i\n"
+      << "  --cpu-interval=<duration>  CPU collection period (default: -i)\n"
+      << "  --mem-interval=<duration>  Memory collection period (default: -i)\n"
+      << "  --disk-interval=<duration> Disk collection period (default: -i)\n"
+      << "  --net-interval=<duration>  Network collection period (default: -i)\n"
+      << "  --proc-interval=<duration> Process collection period (default: -i)\n"
+      << "  --cgroup-interval=<duration> Cgroup collection period (default: -i)\n"
+      << "  --psi-interval=<duration>  Pressure (PSI) collection period (default: -i)\n"
+      << "  --self-interval=<duration> Self-instrumentation period (default: -i)\n"
+      << "  --adaptive=<duration>  Stretch the period of collectors with stable values up to this (default: 0, off)\n"
+      << "  --adaptive-tolerance=<pct> Change that counts as unstable, in percent (default: 5)\n"
       << "  -l=<file>           Set log file path (default: log.txt)\n"
       << "  --log-file=<file>   Same as -l\n"
+      << "  --log-interval=<duration> Interval between log summaries (default: 120s, 0 logs every tick)\n"
+      << "  --log-async         Write the log from a background thread in batches\n"
+      << "  --log-flush=<duration> Async log batch cadence (default: 1s; ERROR flushes at once)\n"
+      << "  --log-queue=<N>     Async log ring size in records (default: 4096)\n"
+      << "  --log-overflow=drop|block  Full async ring: drop the record or wait (default: drop)\n"
       << "  --per-core          Enable per-CPU-core statistics\n"
+      << "  --disk-include=<globs> Only show these block devices, e.g. sd*,nvme* (partitions only if named)\n"
+      << "  --disk-exclude=<globs> Hide these block devices (default: loop*,ram*)\n"
+      << "  --net-include=<globs>  Only show these network interfaces, e.g. eth*,wl*\n"
+      << "  --net-exclude=<globs>  Hide these network interfaces (default: lo)\n"
+      << "  --rollup=<list>     CPU and memory rows per core, socket and/or node, or none (default: node)\n"
+      << "  --pin-cpus=<list>   Pin collector threads to these CPUs (e.g., 0,2-3)\n"
+      << "  --top=<N>           Show the top N processes (default: 10, 0 disables)\n"
+      << "  --top-sort=cpu|rss|io  Rank processes by CPU, resident memory or IO (default: cpu)\n"
+      << "  --cgroup-root=<dir> cgroup v2 mount point (default: /sys/fs/cgroup)\n"
+      << "  --cgroup-depth=<N>  Show cgroups up to N levels deep (default: 2, 0 disables)\n"
+      << "  --psi-stall=<duration>     PSI trigger: stall time per window (default: 100ms, 0ms disables)\n"
+      << "  --psi-window=<duration>    PSI trigger window (default: 2s)\n"
+      << "  --boost-interval=<duration> CPU, memory and disk period after a PSI trigger (default: 100ms)\n"
+      << "  --boost-for=<duration>     How long to keep the boosted period (default: 10s, 0 disables)\n"
+      << "  --net-backend=<b>   Network counters source: auto, netlink or proc (default: auto)\n"
+      << "  --proc-root=<dir>   Read stat, meminfo, diskstats and net/dev from <dir> (default: /proc)\n"
+      << "  --sys-root=<dir>    Read CPU topology and NUMA nodes from <dir> (default: /sys)\n"
+      << "  --record=<file>     Record every sample into a memory-mapped ring file\n"
+      << "  --record-size=<MiB> Size of the record file (default: 64)\n"
+      << "  --output=ndjson|csv Stream one record per tick instead of the screen\n"
+      << "  --history=<MiB>     Keep a compressed in-memory history of every metric (default: 0, off)\n"
+      << "  --output-fd=<N>     File descriptor for --output (default: 1, stdout)\n"
       << "\n"
       << "Duration format:\n"
       << "  <number>s   - seconds (e.g., 1s, 5s)\n"
@@ -58,14 +174,335 @@ std::chrono::milliseconds parseInterval(const std::string& periodStr) {
     }
 }
 
+// Длительность из опции без исключений: ошибка формата — сообщение и false.
+// Период опроса нулевым быть не может (его не примет планировщик); allow_zero —
+// для опций, где ноль выключает возможность.
+bool parsePeriod(const std::string& value, std::chrono::milliseconds& period, bool allow_zero = false) {
+    std::chrono::milliseconds parsed;
+    try {
+        parsed = parseInterval(value);
+    } catch (const std::exception&) {
+        std::cerr << "Invalid interval: " << value << "\n";
+        return false;
+    }
+    if (parsed.count() < 0 || (parsed.count() == 0 && !allow_zero)) {
+        std::cerr << "Interval must be greater than zero: " << value << "\n";
+        return false;
+    }
+    period = parsed;
+    return true;
+}
+
+bool parsePeriod(const std::string& value, std::optional<std::chrono::milliseconds>& period) {
+    std::chrono::milliseconds parsed;
+    if (!parsePeriod(value, parsed)) {
+        return false;
+    }
+    period = parsed;
+    return true;
+}
+
+// Список CPU вида "0,2,4-7"; каждый CPU должен быть доступен процессу
+std::vector<int> parseCpuList(const std::string& list) {
+    std::regex pattern(R"(^(\d+)(?:-(\d+))?$)");
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        throw std::runtime_error("Cannot read the CPU affinity of sysmon");
+    }
+    std::vector<int> cpus;
+    std::size_t start = 0;
+    while (start <= list.size()) {
+        std::size_t end = list.find(',', start);
+        if (end == std::string::npos) {
+            end = list.size();
+        }
+        std::string item = list.substr(start, end - start);
+        std::smatch match;
+        if (!std::regex_match(item, match, pattern)) {
+            throw std::invalid_argument("Invalid CPU list: " + list);
+        }
+        int first = 0;
+        int last = 0;
+        try {
+            first = std::stoi(match[1].str());
+            last = match[2].matched ? std::stoi(match[2].str()) : first;
+        } catch (const std::out_of_range&) {
+            throw std::invalid_argument("CPU number is out of range in " + list);
+        }
+        if (first > last) {
+            throw std::invalid_argument("Invalid CPU list: " + list);
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            if (cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed)) {
+                throw std::invalid_argument("CPU " + std::to_string(cpu) + " is not available to sysmon");
+            }
+            cpus.push_back(cpu);
+        }
+        start = end + 1;
+    }
+    return cpus;
+}
+
+// Если arg начинается с prefix, кладёт остаток в value
+bool matchOption(const std::string& arg, const std::string& prefix, std::string& value) {
+    if (arg.compare(0, prefix.size(), prefix) != 0) {
+        return false;
+    }
+    value = arg.substr(prefix.size());
+    return true;
+}
+
+// Число из значения опции целиком, без исключений; false — не число
+// или не помещается в T (отрицательное для беззнакового в том числе)
+template <typename T>
+bool parseNumber(const std::string& value, T& out) {
+    const char* end = value.data() + value.size();
+    std::from_chars_result result = std::from_chars(value.data(), end, out);
+    return !value.empty() && result.ec == std::errc() && result.ptr == end;
+}
+
+// sysmon dump: записи файла в CSV, от старых к новым
+int runDump(const std::string& path) {
+    RecordFileReader reader(path);
+    const RecordFileHeader& header = reader.header();
+
+    std::string line = "wall_time_s";
+    for (std::uint32_t c = 0; c < header.column_count; ++c) {
+        const RecordColumn& column = reader.columns()[c];
+        line += ',';
+        line += sourceName(static_cast<MetricSource>(column.source));
+        line += '/';
+        line += column.instance;
+        line += '/';
+        line += metricName(static_cast<MetricId>(column.metric));
+    }
+    std::cout << line << '\n';
+
+    char buf[64];
+    for (std::uint64_t k = reader.firstRecord(); k < reader.endRecord(); ++k) {
+        std::uint64_t timestamp_ns = 0;
+        const double* values = reader.values(k, timestamp_ns);
+        if (values == nullptr) {
+            continue;
+        }
+        double wall = (header.start_wall_ns +
+                       (static_cast<std::int64_t>(timestamp_ns) - static_cast<std::int64_t>(header.start_mono_ns))) / 1e9;
+        std::snprintf(buf, sizeof(buf), "%.3f", wall);
+        line = buf;
+        for (std::uint32_t c = 0; c < header.column_count; ++c) {
+            line += ',';
+            if (!std::isnan(values[c])) {
+                std::snprintf(buf, sizeof(buf), "%.17g", values[c]);
+                line += buf;
+            }
+        }
+        std::cout << line << '\n';
+    }
+    return 0;
+}
+
+// sysmon replay: показывает записи тем же форматом, что и живой экран,
+// с исходными паузами между ними, делёнными на speed
+int runReplay(const std::string& path, double speed) {
+    RecordFileReader reader(path);
+    std::vector<MetricSnapshot> snapshots;
+    std::string frame;
+    std::uint64_t prev_timestamp_ns = 0;
+
+    installSignalHandlers();
+    TerminalRenderer renderer(STDOUT_FILENO);
+    for (std::uint64_t k = reader.firstRecord(); k < reader.endRecord() && !g_stop_requested; ++k) {
+        std::uint64_t timestamp_ns = 0;
+        const double* values = reader.values(k, timestamp_ns);
+        if (values == nullptr) {
+            continue;
+        }
+        if (prev_timestamp_ns != 0 && timestamp_ns > prev_timestamp_ns) {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(
+                static_cast<std::int64_t>((timestamp_ns - prev_timestamp_ns) / speed)));
+        }
+        prev_timestamp_ns = timestamp_ns;
+
+        if (g_resized) {
+            g_resized = 0;
+            renderer.invalidate();
+        }
+        reader.buildSnapshots(values, timestamp_ns, snapshots);
+        frame = "SysMon replay " + path + " - record " + std::to_string(k + 1) + "/" +
+                std::to_string(reader.endRecord()) + "\n";
+        for (const MetricSnapshot& snapshot : snapshots) {
+            formatSnapshot(snapshot, frame);
+            frame += "\n";
+        }
+        renderer.render(frame);
+    }
+    return 0;
+}
+
+// sysmon fixture capture|generate|replay: фикстуры /proc для замеров разбора
+int runFixture(int argc, char* argv[]) {
+    std::string command = argv[2];
+    std::string dir = argv[3];
+    std::string proc_root = "/proc";
+    std::chrono::milliseconds interval = std::chrono::seconds(1);
+    std::size_t rounds = 1;
+    bool per_core = false;
+    SyntheticFixtureSpec spec;
+    for (int i = 4; i < argc; i++) {
+        std::string arg = argv[i];
+        std::string value;
+        if (matchOption(arg, "--frames=", value)) {
+            if (!parseNumber(value, spec.frames)) {
+                std::cerr << "Invalid value: " << arg << "\n";
+                return 1;
+            }
+        } else if (matchOption(arg, "-i=", value) || matchOption(arg, "--interval=", value)) {
+            if (!parsePeriod(value, interval)) {
+                return 1;
+            }
+        } else if (matchOption(arg, "--proc-root=", value)) {
+            proc_root = value;
+        } else if (matchOption(arg, "--cpus=", value)) {
+            if (!parseNumber(value, spec.cpus)) {
+                std::cerr << "Invalid value: " << arg << "\n";
+                return 1;
+            }
+        } else if (matchOption(arg, "--disks=", value)) {
+            if (!parseNumber(value, spec.disks)) {
+                std::cerr << "Invalid value: " << arg << "\n";
+                return 1;
+            }
+        } else if (matchOption(arg, "--interfaces=", value)) {
+            if (!parseNumber(value, spec.interfaces)) {
+                std::cerr << "Invalid value: " << arg << "\n";
+                return 1;
+            }
+        } else if (matchOption(arg, "--rounds=", value)) {
+            // Ноль раундов даёт пустую статистику и деление на ноль в отчёте
+            if (!parseNumber(value, rounds) || rounds == 0) {
+                std::cerr << "Invalid number of rounds: " << value << "\n";
+                return 1;
+            }
+        } else if (arg == "--per-core") {
+            per_core = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << "\n";
+            return 1;
+        }
+    }
+
+    if (command == "capture") {
+        captureFixture(dir, proc_root, spec.frames, interval);
+        std::cout << "Captured " << spec.frames << " frames into " << dir << "\n";
+        return 0;
+    }
+    if (command == "generate") {
+        generateFixture(dir, spec);
+        std::cout << "Generated " << spec.frames << " frames into " << dir << "\n";
+        return 0;
+    }
+    if (command == "replay") {
+        Logger logger("/dev/null", Logger::Level::ERROR);
+        FixtureReplayStats stats = replayFixture(dir, rounds, per_core, logger);
+        double total_s = 0;
+        char line[128];
+        for (std::size_t i = 0; i < kFixtureFiles.size(); ++i) {
+            double seconds = std::chrono::duration<double>(stats.collect_time[i]).count();
+            total_s += seconds;
+            std::snprintf(line, sizeof(line), "%-10s %10.1f us/frame\n", kFixtureFiles[i],
+                          seconds * 1e6 / stats.frames);
+            std::cout << line;
+        }
+        std::snprintf(line, sizeof(line), "%zu frames, %.1f MiB parsed, %.1f frames/s, %.1f MiB/s\n",
+                      stats.frames, stats.bytes / 1048576.0, stats.frames / total_s,
+                      stats.bytes / 1048576.0 / total_s);
+        std::cout << line;
+        return 0;
+    }
+    std::cerr << "Unknown fixture command: " << command << "\n";
+    return 1;
+}
+
 int main(int argc, char* argv[]) {
+    if (argc >= 3 && std::string(argv[1]) == "dump") {
+        try {
+            return runDump(argv[2]);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (argc >= 3 && std::string(argv[1]) == "replay") {
+        double speed = 1.0;
+        std::string value;
+        if (argc >= 4 && matchOption(argv[3], "--speed=", value) && !parseNumber(value, speed)) {
+            std::cerr << "Invalid replay speed: " << value << "\n";
+            return 1;
+        }
+        if (!(speed > 0)) {
+            std::cerr << "Replay speed must be > 0\n";
+            return 1;
+        }
+        try {
+            return runReplay(argv[2], speed);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+    if (argc >= 4 && std::string(argv[1]) == "fixture") {
+        try {
+            return runFixture(argc, argv);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+    }
+
+
     std::string log_filename = "log.txt";
     bool per_core = false;
     std::chrono::milliseconds interval = std::chrono::seconds(1);
     std::chrono::time_point last_log_time = std::chrono::steady_clock::now();
     std::chrono::milliseconds log_interval = std::chrono::seconds(120);
+    std::optional<std::chrono::milliseconds> cpu_interval;
+    std::optional<std::chrono::milliseconds> mem_interval;
+    std::optional<std::chrono::milliseconds> disk_interval;
+    std::optional<std::chrono::milliseconds> net_interval;
+    std::optional<std::chrono::milliseconds> proc_interval;
+    std::optional<std::chrono::milliseconds> cgroup_interval;
+    std::string cgroup_root = "/sys/fs/cgroup";
+    std::size_t cgroup_depth = 2;
+    std::optional<std::chrono::milliseconds> psi_interval;
+    std::optional<std::chrono::milliseconds> self_interval;
+    std::chrono::milliseconds adaptive_max(0);
+    double adaptive_tolerance = 5.0;
+    std::chrono::milliseconds psi_stall(100);
+    std::chrono::milliseconds psi_window(2000);
+    std::chrono::milliseconds boost_interval(100);
+    std::chrono::milliseconds boost_for(10000);
+    std::size_t top_n = 10;
+    ProcessSort top_sort = ProcessSort::CPU;
+    std::vector<int> pin_cpus;
+    std::string proc_root = "/proc";
+    std::string sys_root = "/sys";
+    unsigned rollups = 1u << GROUP_NODE;
+    std::string disk_include;
+    std::string disk_exclude = "loop*,ram*";
+    std::string net_include;
+    std::string net_exclude = "lo";
+    NetBackend net_backend = NetBackend::AUTO;
+    std::string record_filename;
+    std::uint64_t record_size_mib = 64;
+    std::optional<StreamFormat> output_format;
+    int output_fd = STDOUT_FILENO;
+    std::size_t history_mib = 0;
+    bool log_async = false;
+    Logger::AsyncOptions log_options;
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
+        std::string value;
 
         if (arg == "help") {
             printHelp();
@@ -74,20 +511,235 @@ int main(int argc, char* argv[]) {
             printVersion();
             return 0;
         }
-        else if (arg.size() >= 3 && arg.substr(0, 3) == "-i=") {
-            interval = parseInterval(arg.substr(3));
+        else if (matchOption(arg, "-i=", value) || matchOption(arg, "--interval=", value)) {
+            if (!parsePeriod(value, interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--cpu-interval=", value)) {
+            if (!parsePeriod(value, cpu_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--mem-interval=", value)) {
+            if (!parsePeriod(value, mem_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--disk-interval=", value)) {
+            if (!parsePeriod(value, disk_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--net-interval=", value)) {
+            if (!parsePeriod(value, net_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--proc-interval=", value)) {
+            if (!parsePeriod(value, proc_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--cgroup-interval=", value)) {
+            if (!parsePeriod(value, cgroup_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--psi-interval=", value)) {
+            if (!parsePeriod(value, psi_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--psi-stall=", value)) {
+            if (!parsePeriod(value, psi_stall, true)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--psi-window=", value)) {
+            if (!parsePeriod(value, psi_window)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--boost-interval=", value)) {
+            if (!parsePeriod(value, boost_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--boost-for=", value)) {
+            if (!parsePeriod(value, boost_for, true)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--self-interval=", value)) {
+            if (!parsePeriod(value, self_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--adaptive=", value)) {
+            if (!parsePeriod(value, adaptive_max, true)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--adaptive-tolerance=", value)) {
+            // Отрицательный допуск делал бы «изменившимся» каждый снимок
+            if (!parseNumber(value, adaptive_tolerance) || !std::isfinite(adaptive_tolerance) ||
+                adaptive_tolerance < 0) {
+                std::cerr << "Invalid adaptive tolerance: " << value << " (expected a percentage >= 0)\n";
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "-l=", value) || matchOption(arg, "--log-file=", value)) {
+            log_filename = value;
+        }
+        else if (matchOption(arg, "--log-interval=", value)) {
+            if (!parsePeriod(value, log_interval, true)) {
+                return 1;
+            }
+        }
+        else if (arg == "--log-async") {
+            log_async = true;
+        }
+        else if (matchOption(arg, "--log-flush=", value)) {
+            if (!parsePeriod(value, log_options.flush_interval)) {
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--log-queue=", value)) {
+            // Каждая запись кольца заранее резервирует буфер — размер ограничиваем
+            if (!parseNumber(value, log_options.capacity) || log_options.capacity == 0 ||
+                log_options.capacity > (std::size_t{1} << 20)) {
+                std::cerr << "Invalid log queue size: " << value << " (expected 1 to 1048576 records)\n";
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--log-overflow=", value)) {
+            if (value == "drop") {
+                log_options.overflow = Logger::OverflowPolicy::DROP;
+            } else if (value == "block") {
+                log_options.overflow = Logger::OverflowPolicy::BLOCK;
+            } else {
+                std::cerr << "Unknown log overflow policy: " << value << "\n";
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--pin-cpus=", value)) {
+            try {
+                pin_cpus = parseCpuList(value);
+            } catch (const std::exception& e) {
+                std::cerr << e.what() << "\n";
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--proc-root=", value)) {
+            proc_root = value;
+        }
+        else if (matchOption(arg, "--disk-include=", value)) {
+            disk_include = value;
+        }
+        else if (matchOption(arg, "--disk-exclude=", value)) {
+            disk_exclude = value;
+        }
+        else if (matchOption(arg, "--net-include=", value)) {
+            net_include = value;
+        }
+        else if (matchOption(arg, "--net-exclude=", value)) {
+            net_exclude = value;
+        }
+        else if (matchOption(arg, "--sys-root=", value)) {
+            sys_root = value;
+        }
+        else if (matchOption(arg, "--rollup=", value)) {
+            rollups = 0;
+            std::size_t start = 0;
+            while (start <= value.size()) {
+                std::size_t comma = std::min(value.find(',', start), value.size());
+                std::string kind = value.substr(start, comma - start);
+                if (kind == "core") {
+                    rollups |= 1u << GROUP_CORE;
+                } else if (kind == "socket") {
+                    rollups |= 1u << GROUP_SOCKET;
+                } else if (kind == "node") {
+                    rollups |= 1u << GROUP_NODE;
+                } else if (kind != "none") {
+                    std::cerr << "Unknown rollup: " << kind << "\n";
+                    return 1;
+                }
+                start = comma + 1;
+            }
+        }
+        else if (matchOption(arg, "--top=", value)) {
+            if (!parseNumber(value, top_n)) {
+                std::cerr << "Invalid number of processes: " << value << "\n";
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--top-sort=", value)) {
+            if (value == "cpu") {
+                top_sort = ProcessSort::CPU;
+            } else if (value == "rss") {
+                top_sort = ProcessSort::RSS;
+            } else if (value == "io") {
+                top_sort = ProcessSort::IO;
+            } else {
+                std::cerr << "Unknown process sort key: " << value << "\n";
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--cgroup-root=", value)) {
+            cgroup_root = value;
+        }
+        else if (matchOption(arg, "--cgroup-depth=", value)) {
+            if (!parseNumber(value, cgroup_depth)) {
+                std::cerr << "Invalid cgroup depth: " << value << "\n";
+                return 1;
+            }
         }
-        else if (arg.size() >= 12 && arg.substr(0, 12) == "--interval=") {
-            interval = parseInterval(arg.substr(12));
+        else if (matchOption(arg, "--net-backend=", value)) {
+            if (value == "auto") {
+                net_backend = NetBackend::AUTO;
+            } else if (value == "netlink") {
+                net_backend = NetBackend::NETLINK;
+            } else if (value == "proc") {
+                net_backend = NetBackend::PROC;
+            } else {
+                std::cerr << "Unknown network backend: " << value << "\n";
+                return 1;
+            }
         }
-        else if (arg.size() >= 3 && arg.substr(0, 3) == "-l=") {
-            log_filename = arg.substr(3);
+        else if (matchOption(arg, "--record=", value)) {
+            record_filename = value;
         }
-        else if (arg.size() >= 11 && arg.substr(0, 11) == "--log-file=") {
-            log_filename = arg.substr(11);
+        else if (matchOption(arg, "--record-size=", value)) {
+            // Сдвиг на 20 бит не должен переполниться; меньше мегабайта файл не бывает
+            if (!parseNumber(value, record_size_mib) || record_size_mib == 0 ||
+                record_size_mib > (std::uint64_t{1} << 20)) {
+                std::cerr << "Invalid record size: " << value << " MiB\n";
+                return 1;
+            }
         }
-        else if (arg.size() >= 15 && arg.substr(0, 15) == "--log-interval=") {
-            log_interval = parseInterval(arg.substr(15));
+        else if (matchOption(arg, "--output=", value)) {
+            if (value == "ndjson") {
+                output_format = StreamFormat::NDJSON;
+            } else if (value == "csv") {
+                output_format = StreamFormat::CSV;
+            } else {
+                std::cerr << "Unknown output format: " << value << "\n";
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--output-fd=", value)) {
+            if (!parseNumber(value, output_fd) || output_fd < 0) {
+                std::cerr << "Invalid output fd: " << value << "\n";
+                return 1;
+            }
+        }
+        else if (matchOption(arg, "--history=", value)) {
+            // Как и --record-size: сдвиг на 20 бит не должен переполниться
+            if (!parseNumber(value, history_mib) || history_mib > (std::size_t{1} << 20)) {
+                std::cerr << "Invalid history size: " << value << " MiB\n";
+                return 1;
+            }
         }
         else if (arg == "--per-core") {
             per_core = true;
@@ -99,16 +751,52 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    Logger logger(log_filename);
+    // Файл записи создаётся позже, когда известна схема, — путь проверяем сразу
+    if (!record_filename.empty()) {
+        int record_fd = ::open(record_filename.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+        if (record_fd < 0) {
+            std::cerr << "Cannot open record file " << record_filename << "\n";
+            return 1;
+        }
+        ::close(record_fd);
+    }
+
+    std::unique_ptr<StreamWriter> stream;
+    if (output_format) {
+        try {
+            stream = std::make_unique<StreamWriter>(output_fd, *output_format);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 1;
+        }
+        // Закрытый читатель потока — это EPIPE от write(), а не смерть от сигнала
+        std::signal(SIGPIPE, SIG_IGN);
+    }
+
+    installSignalHandlers();
+    setSignalsBlocked(true);
+    std::unique_ptr<Logger> logger_ptr = log_async
+        ? std::make_unique<Logger>(log_filename, Logger::Level::INFO, log_options)
+        : std::make_unique<Logger>(log_filename);
+    Logger& logger = *logger_ptr;
     logger.info("Start with interval: " + std::to_string(interval.count()) + "ms");
     if (per_core) {
         logger.info("Per-core CPU stats enabled");
     }
 
-    std::unique_ptr<CpuCollector> cpu = std::make_unique<CpuCollector>(per_core, logger);
-    std::unique_ptr<MemoryCollector> memory = std::make_unique<MemoryCollector>(logger);
-    std::unique_ptr<DiskCollector> disk = std::make_unique<DiskCollector>(interval, logger);
-    std::unique_ptr<NetCollector> net = std::make_unique<NetCollector>(interval, logger);
+    // Планировщик объявлен до коллекторов: поток PSI-триггеров будит его до своей остановки
+    CollectorScheduler scheduler;
+
+    std::unique_ptr<CpuCollector> cpu = std::make_unique<CpuCollector>(per_core, proc_root, logger);
+    std::unique_ptr<MemoryCollector> memory = std::make_unique<MemoryCollector>(proc_root, logger);
+    cpu->enableRollups(sys_root, rollups);
+    if (rollups & (1u << GROUP_NODE)) {
+        memory->enableNodes(sys_root);
+    }
+    std::unique_ptr<DiskCollector> disk = std::make_unique<DiskCollector>(
+        proc_root, sys_root, DeviceFilter(disk_include, disk_exclude), logger);
+    std::unique_ptr<NetCollector> net = std::make_unique<NetCollector>(
+        proc_root, net_backend, DeviceFilter(net_include, net_exclude), logger);
 
     std::vector<std::unique_ptr<IMetricCollector>> collectors;
     collectors.push_back(std::move(cpu));
@@ -116,44 +804,321 @@ int main(int argc, char* argv[]) {
     collectors.push_back(std::move(disk));
     collectors.push_back(std::move(net));
 
-    ThreadPool pool(collectors.size());
+    scheduler.add(*collectors[0], cpu_interval.value_or(interval));
+    scheduler.add(*collectors[1], mem_interval.value_or(interval));
+    scheduler.add(*collectors[2], disk_interval.value_or(interval));
+    scheduler.add(*collectors[3], net_interval.value_or(interval));
 
-    while (true) {
-        std::vector<std::future<void>> futures;
-        for (std::unique_ptr<IMetricCollector>& collector : collectors) {
-            futures.emplace_back(pool.enqueue([&collector]() {
-                collector->collect();
-            }));
+    ProcessCollector* processes = nullptr;
+    if (top_n > 0) {
+        std::unique_ptr<ProcessCollector> process = std::make_unique<ProcessCollector>(proc_root, top_n, top_sort, logger);
+        processes = process.get();
+        collectors.push_back(std::move(process));
+        scheduler.add(*collectors.back(), proc_interval.value_or(interval));
+    }
+    if (cgroup_depth > 0) {
+        // Без cgroup v2 (старые ядра, чистый v1) просто работаем без этого раздела
+        try {
+            collectors.push_back(std::make_unique<CgroupCollector>(cgroup_root, cgroup_depth, logger));
+            scheduler.add(*collectors.back(), cgroup_interval.value_or(interval));
+        } catch (const std::exception& e) {
+            logger.warning(std::string("Cgroup stats disabled: ") + e.what());
+        }
+    }
+
+    // При срабатывании PSI-триггера ускоряем CPU, память, диски и сам PSI
+    PressureCollector* pressure = nullptr;
+    std::vector<std::size_t> boost_targets = {0, 1, 2};
+    try {
+        std::unique_ptr<PressureCollector> psi = std::make_unique<PressureCollector>(proc_root, logger);
+        pressure = psi.get();
+        collectors.push_back(std::move(psi));
+        boost_targets.push_back(scheduler.add(*collectors.back(), psi_interval.value_or(interval)));
+    } catch (const std::exception& e) {
+        logger.warning(std::string("Pressure stats disabled: ") + e.what());
+    }
+    // Коллектор уже работает: без триггеров остаётся только опрос по периоду
+    if (pressure && psi_stall.count() > 0) {
+        try {
+            pressure->watchTriggers(psi_stall, psi_window, [&scheduler] { scheduler.wake(); });
+        } catch (const std::exception& e) {
+            logger.warning(std::string("PSI triggers disabled: ") + e.what());
+        }
+    }
+    std::chrono::steady_clock::time_point boost_until{};
+
+    // Самоизмерение — последним, чтобы видеть задержки всех остальных
+    std::unique_ptr<SelfCollector> self_ptr = std::make_unique<SelfCollector>(scheduler, logger);
+    SelfCollector& self = *self_ptr;
+    collectors.push_back(std::move(self_ptr));
+    scheduler.add(*collectors.back(), self_interval.value_or(interval));
+
+    // Адаптивный режим: у каждого коллектора свой трекер и номер последнего разобранного снимка
+    scheduler.setAdaptive(adaptive_max);
+    std::vector<StabilityTracker> trackers(collectors.size(), StabilityTracker(adaptive_tolerance / 100.0));
+    std::vector<std::uint64_t> tracked_sequence(collectors.size(), 0);
+    if (adaptive_max.count() > 0) {
+        logger.info("Adaptive sampling up to " + std::to_string(adaptive_max.count()) + "ms");
+    }
+
+    // Флаги «коллектор ещё собирает» и «есть свежие данные для экрана».
+    // Объявлены до пула: задачи пула обращаются к ним до его остановки.
+    std::vector<std::atomic<bool>> busy(collectors.size());
+    std::atomic<bool> fresh_data{false};
+    std::vector<LatencyHistogram> collect_latency(collectors.size());
+    LatencyHistogram render_latency;
+    LatencyHistogram log_latency;
+    LatencyHistogram output_latency;
+    // Первые снимки, ещё не попавшие в поток и в файл записи (см. tickReady)
+    std::chrono::steady_clock::time_point output_pending{};
+    std::chrono::steady_clock::time_point record_pending{};
+    for (std::size_t i = 0; i < collectors.size(); ++i) {
+        self.addLatency(std::string("collect.") + sourceName(collectors[i]->snapshot()->source), collect_latency[i]);
+    }
+    std::vector<std::size_t> due;
+    std::string frame;
+    std::unique_ptr<MetricRecorder> recorder;
+    // История: номер последнего записанного снимка каждого коллектора
+    std::unique_ptr<TimeSeriesStore> history;
+    std::vector<std::uint64_t> history_sequence(collectors.size(), 0);
+    std::vector<SeriesSample> history_points;
+    LatencyHistogram history_latency;
+    bool history_warned = false;
+    if (history_mib > 0) {
+        try {
+            history = std::make_unique<TimeSeriesStore>(history_mib << 20);
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot keep " << history_mib << " MiB of history: " << e.what() << "\n";
+            return 1;
+        }
+        self.addLatency("history", history_latency);
+        logger.info("Keeping up to " + std::to_string(history_mib) + " MiB of history");
+    }
+
+    ThreadPool pool(collectors.size(), pin_cpus);
+    if (processes) {
+        processes->shardAcross(pool);
+    }
+    self.addLatency("pool.queue_wait", pool.queueWait());
+    self.addLatency("render", render_latency);
+    self.addLatency("log", log_latency);
+    if (stream) {
+        self.addLatency("output", output_latency);
+    }
+
+    // Все потоки (логгер, PSI, пул) запущены — сигналы снова принимает главный
+    setSignalsBlocked(false);
+    // Поток в stdout занимает его целиком — экран тогда не рисуем
+    std::unique_ptr<TerminalRenderer> renderer;
+    if (!stream || output_fd != STDOUT_FILENO) {
+        renderer = std::make_unique<TerminalRenderer>(STDOUT_FILENO);
+    }
+
+    while (!g_stop_requested) {
+        std::uint64_t missed = scheduler.waitDue(due);
+        if (missed > 0) {
+            logger.warning("Missed " + std::to_string(missed) + " tick(s), total " +
+                           std::to_string(scheduler.missedTicks()));
+        }
+
+        unsigned stalled = pressure ? pressure->takeEvents() : 0;
+        if (stalled != 0) {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now >= boost_until) {
+                std::string resources;
+                const char* names[] = {"cpu", "memory", "io"};
+                for (unsigned bit = 0; bit < 3; ++bit) {
+                    if (stalled & (1u << bit)) {
+                        resources += resources.empty() ? names[bit] : std::string(", ") + names[bit];
+                    }
+                }
+                logger.info("Pressure stall (" + resources + "), sampling every " +
+                            std::to_string(boost_interval.count()) + "ms for " +
+                            std::to_string(boost_for.count()) + "ms");
+            }
+            boost_until = now + boost_for;
+            for (std::size_t index : boost_targets) {
+                scheduler.boost(index, boost_interval, boost_until);
+            }
+        }
+
+        // Запускаем только те коллекторы, у которых подошёл срок. Результат
+        // не ждём: снимки публикуются через SnapshotBuffer, а о готовности
+        // задача сообщает, разбудив планировщик.
+        for (std::size_t index : due) {
+            if (busy[index].exchange(true)) {
+                // Предыдущий сбор ещё идёт — этот дедлайн пропускаем
+                scheduler.markMissed();
+                continue;
+            }
+            // Захват — ровно Task::kInlineSize байт, задача не выделяет память
+            pool.submit([&scheduler, &busy, &fresh_data, &collect_latency, &logger, index]() {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                try {
+                    scheduler.collector(index).collect();
+                } catch (const std::exception& e) {
+                    logger.error(e.what());
+                }
+                collect_latency[index].record(std::chrono::steady_clock::now() - start);
+                busy[index].store(false);
+                fresh_data.store(true);
+                scheduler.wake();
+            });
+        }
+
+        bool resized = g_resized;
+        if (resized) {
+            g_resized = 0;
+            if (renderer) {
+                renderer->invalidate();
+            }
+        }
+        bool fresh = fresh_data.exchange(false);
+        if (!fresh && !resized) {
+            continue;
+        }
+        bool collecting = false;
+        for (std::atomic<bool>& flag : busy) {
+            collecting = collecting || flag.load();
         }
-        for (std::future<void> &f : futures) {
-          f.get();
+
+        if (fresh && adaptive_max.count() > 0) {
+            for (std::size_t i = 0; i < collectors.size(); ++i) {
+                SnapshotGuard snapshot = collectors[i]->snapshot();
+                if (snapshot.sequence() != tracked_sequence[i]) {
+                    tracked_sequence[i] = snapshot.sequence();
+                    scheduler.reportChange(i, trackers[i].update(*snapshot));
+                }
+            }
+        }
+
+        if (fresh && !record_filename.empty()) {
+            // Схему файла фиксируем, когда каждый коллектор опубликовал хоть что-то
+            if (!recorder) {
+                bool ready = true;
+                for (std::unique_ptr<IMetricCollector>& collector : collectors) {
+                    ready = ready && collector->snapshot().sequence() > 0;
+                }
+                if (ready) {
+                    try {
+                        recorder = std::make_unique<MetricRecorder>(record_filename, record_size_mib << 20, collectors);
+                        logger.info("Recording " + std::to_string(recorder->columnCount()) + " columns, " +
+                                    std::to_string(recorder->capacity()) + " records to " + record_filename);
+                    } catch (const std::exception& e) {
+                        // Мониторинг продолжается и без записи
+                        logger.error(std::string("Recording disabled: ") + e.what());
+                        record_filename.clear();
+                    }
+                }
+            }
+            // Одна запись за тик, как и в потоке
+            std::chrono::steady_clock::time_point record_now = std::chrono::steady_clock::now();
+            if (recorder && tickReady(record_pending, record_now, collecting, interval)) {
+                recorder->record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    record_now.time_since_epoch()).count()));
+            }
+        }
+
+        if (fresh && history) {
+            std::chrono::steady_clock::time_point history_start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < collectors.size(); ++i) {
+                SnapshotGuard snapshot = collectors[i]->snapshot();
+                if (snapshot.sequence() != history_sequence[i]) {
+                    history_sequence[i] = snapshot.sequence();
+                    history->append(i, *snapshot);
+                }
+            }
+            if (!history_warned && history->seriesCount() * TimeSeriesStore::blockBytes() > history->budgetBytes()) {
+                history_warned = true;
+                logger.warning("History budget fits less than one block per series (" +
+                               std::to_string(history->seriesCount()) + " series); raise --history");
+            }
+            history_latency.record(std::chrono::steady_clock::now() - history_start);
         }
 
-        std::system("clear");
-        std::cout << "SysMon - press ctrl + C for exit.\n";
+        if (fresh && stream) {
+            std::chrono::steady_clock::time_point output_start = std::chrono::steady_clock::now();
+            if (tickReady(output_pending, output_start, collecting, interval)) {
+                if (!stream->write(collectors, output_start)) {
+                    logger.warning("Output closed, stopping");
+                    break;
+                }
+                output_latency.record(std::chrono::steady_clock::now() - output_start);
+            }
+        }
+
+        // Текст строится один раз за тик и идёт и на экран, и в сводку
+        std::chrono::steady_clock::time_point render_start = std::chrono::steady_clock::now();
+        if (!renderer && render_start - last_log_time < log_interval) {
+            continue;
+        }
+        frame.clear();
+        frame += "SysMon - press ctrl + C for exit.";
+        if (scheduler.missedTicks() > 0) {
+            frame += " Missed ticks: " + std::to_string(scheduler.missedTicks());
+        }
+        if (scheduler.skippedCollections() > 0) {
+            frame += " Skipped: " + std::to_string(scheduler.skippedCollections());
+        }
+        frame += "\n";
+        std::size_t body_start = frame.size();
         for (std::unique_ptr<IMetricCollector>& collector : collectors) {
-            std::cout << collector->getFormattedData() << std::endl;
+            formatSnapshot(*collector->snapshot(), frame);
+            frame += "\n";
         }
-        
         std::chrono::time_point now = std::chrono::steady_clock::now();
+        if (renderer) {
+            renderer->render(frame);
+            now = std::chrono::steady_clock::now();
+            render_latency.record(now - render_start);
+        }
         if (now - last_log_time >= log_interval) {
             logger.info("=== System Summary start ===");
-            for (std::unique_ptr<IMetricCollector>& collector : collectors) {
-                std::string data = collector->getFormattedData();
-                std::istringstream iss(data);
-                std::string line;
-                while (std::getline(iss, line)) {
-                    if (!line.empty()) {
-                        logger.info(line);
-                    }
+            std::string_view text = std::string_view(frame).substr(body_start);
+            std::string_view line;
+            while (nextLine(text, line)) {
+                if (!line.empty()) {
+                    logger.info(std::string(line));
                 }
             }
+            if (adaptive_max.count() > 0) {
+                logger.info("Adaptive sampling skipped " + std::to_string(scheduler.skippedCollections()) +
+                            " collections");
+            }
+            if (history) {
+                // Загрузка CPU за всё, что осталось в истории
+                history_points.clear();
+                history->query(history->findSeries("cpu/total/cpu.usage_percent"),
+                               INT64_MIN, INT64_MAX, history_points);
+                double sum = 0;
+                double peak = 0;
+                for (const SeriesSample& point : history_points) {
+                    sum += point.value;
+                    peak = std::max(peak, point.value);
+                }
+                std::string line = "History: " + std::to_string(history->seriesCount()) + " series, " +
+                                   std::to_string(history->samples()) + " samples in ";
+                appendFixed(line, history->bytesUsed() / 1048576.0, 1);
+                line += " MiB (";
+                appendFixed(line, history->samples() ? static_cast<double>(history->bytesUsed()) / history->samples() : 0.0, 2);
+                line += " bytes/sample), evicted " + std::to_string(history->evictedBlocks()) + " blocks";
+                if (history_points.size() > 1) {
+                    line += "; CPU over the last ";
+                    appendFixed(line, (history_points.back().time_ms - history_points.front().time_ms) / 1000.0, 0);
+                    line += "s: avg ";
+                    appendFixed(line, sum / history_points.size(), 1);
+                    line += "%, max ";
+                    appendFixed(line, peak, 1);
+                    line += '%';
+                }
+                logger.info(line);
+            }
             last_log_time = now;
             logger.info("=== System Summary end ===");
+            log_latency.record(std::chrono::steady_clock::now() - now);
         }
-
-        std::this_thread::sleep_for(interval);
     }
 
+    logger.info("Stop.");
     return 0;
 }
\ No newline at end of file